@@ -4,27 +4,107 @@
 #include "sc_error_types.hpp"
 #include "sc_integer_types.hpp"
 
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <exception>
 #include <limits>
+#include <new>
+#include <optional>
 #include <tl/expected.hpp>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace surge::allocators {
 
+// Size of a cache line on the platforms we target
+inline constexpr usize cache_line_size{64};
+
+/*
+ * Always-on memory accounting. Every heap allocation made through the mimalloc wrappers is counted
+ * under a tag using relaxed atomics, so the counters are cheap enough for release builds. Memory
+ * must be freed with the same tag it was allocated with.
+ */
+namespace accounting {
+
+enum class tag : u8 { general, textures, fonts, vulkan, config, count };
+
+inline constexpr usize tag_count{static_cast<usize>(tag::count)};
+
+struct tag_stats {
+  usize current_bytes{0}; // Bytes currently allocated
+  usize peak_bytes{0};    // Largest value current_bytes has reached
+  usize alloc_count{0};   // Number of allocations, including reallocations
+  usize free_count{0};    // Number of frees, including reallocations
+};
+
+using snapshot_t = std::array<tag_stats, tag_count>;
+
+void record_alloc(tag t, usize bytes) noexcept;
+void record_free(tag t, usize bytes) noexcept;
+
+auto get(tag t) noexcept -> tag_stats;
+auto snapshot() noexcept -> snapshot_t;
+auto tag_name(tag t) noexcept -> const char *;
+
+} // namespace accounting
+
 namespace mimalloc {
 
+using accounting::tag;
+
 void init();
 
-auto malloc(usize size) -> void *;
-auto realloc(void *p, usize newsize) -> void *;
-auto calloc(usize count, usize size) -> void *;
-void free(void *p);
+/*
+ * Reserves a dedicated region of OS memory, optionally backed by large OS pages, from which engine
+ * arenas (program scope, frame scope and concurrent arenas) take their buffers. Must be called
+ * from the main thread, before the arenas that should live in it are created. The players reserve
+ * it once the config is parsed, so the frame arenas live in it, while the program scope arena,
+ * created before the config is read, only takes the chunks it grows by from it. When the region is
+ * exhausted or was never reserved, arenas fall back to the global heap.
+ */
+auto reserve_arena_memory(usize size, bool huge_pages) -> std::optional<error>;
+
+/*
+ * Opaque mimalloc heap. Allocations made through the functions above come from the default heap of
+ * the calling thread, and a heap may only allocate from the thread that created it.
+ */
+struct heap_t;
+
+auto heap_new() noexcept -> heap_t *;
+void heap_destroy(heap_t *h) noexcept; // Frees every block still allocated in h at once
+auto heap_set_default(heap_t *h) noexcept -> heap_t *;
+auto heap_get_backing() noexcept -> heap_t *; // The heap the calling thread started with
+auto heap_used_bytes(const heap_t *h) noexcept -> usize;
+
+// Makes a heap the default heap of the calling thread for the lifetime of the scope
+class heap_scope {
+private:
+  heap_t *previous{nullptr};
+
+public:
+  explicit heap_scope(heap_t *h) noexcept
+      : previous{h != nullptr ? heap_set_default(h) : nullptr} {}
+
+  ~heap_scope() noexcept {
+    if (previous != nullptr) {
+      heap_set_default(previous);
+    }
+  }
+
+  heap_scope(const heap_scope &) = delete;
+  auto operator=(const heap_scope &) -> heap_scope & = delete;
+};
+
+auto malloc(usize size, tag t = tag::general) -> void *;
+auto realloc(void *p, usize newsize, tag t = tag::general) -> void *;
+auto calloc(usize count, usize size, tag t = tag::general) -> void *;
+void free(void *p, tag t = tag::general);
 
-auto aligned_alloc(usize size, usize alignment) -> void *;
-auto aligned_realloc(void *p, usize newsize, usize alignment) -> void *;
-void aligned_free(void *p, usize alignment);
+auto aligned_alloc(usize size, usize alignment, tag t = tag::general) -> void *;
+auto aligned_realloc(void *p, usize newsize, usize alignment, tag t = tag::general) -> void *;
+void aligned_free(void *p, usize alignment, tag t = tag::general);
 
 template <class T> struct cpp_allocator {
   using value_type = T;
@@ -64,23 +144,36 @@ private:
 
   usize capacity{0};
   usize offset{0};
+  usize padding{0};
 
 public:
   arena(usize capacity);
   auto allocate(usize size, usize alignment) -> void *;
   void reset();
   auto size() const -> usize;
+  auto wasted() const -> usize;
 };
 
+/*
+ * Stateful allocator over an arena. Containers using it never free memory, everything they
+ * allocated (including buffers left behind when they grow) is released by resetting the arena.
+ */
 template <class T> class arena_cpp_allocator {
 private:
   arena *arena_allocator;
 
 public:
   using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
 
   arena_cpp_allocator(arena *a) : arena_allocator{a} {}
 
+  template <class U> constexpr arena_cpp_allocator(const arena_cpp_allocator<U> &other)
+      : arena_allocator{other.get_arena()} {}
+
+  [[nodiscard]] auto get_arena() const noexcept -> arena * { return arena_allocator; }
+
   [[nodiscard]] auto allocate(std::size_t n) -> T * {
     if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
       throw std::bad_array_new_length();
@@ -95,6 +188,52 @@ public:
   void deallocate(T *, std::size_t) noexcept {}
 };
 
+template <class T, class U>
+auto operator==(const arena_cpp_allocator<T> &a, const arena_cpp_allocator<U> &b) -> bool {
+  return a.get_arena() == b.get_arena();
+}
+
+template <class T, class U>
+auto operator!=(const arena_cpp_allocator<T> &a, const arena_cpp_allocator<U> &b) -> bool {
+  return a.get_arena() != b.get_arena();
+}
+
+/*
+ * Arena that can be allocated from by many threads at once. Threads carve cache-line-aligned
+ * sub-blocks out of the shared buffer with an atomic compare-exchange and serve small requests from
+ * their current sub-block without further synchronization. Sub-blocks are capped to a share of the
+ * capacity per thread and only carved from the first half of the buffer, so threads that arrive
+ * late still find room. Requests larger than half a sub-block, and every refill once half the
+ * buffer is reserved, are reserved directly from the shared buffer with their exact size. Memory
+ * is not zeroed. reset() must only be called at a fence, when no thread is allocating from the
+ * arena.
+ */
+class concurrent_arena {
+private:
+  std::byte *data{nullptr};
+  usize capacity{0};
+  usize sub_block_size{0};
+  u64 id{0};
+
+  std::atomic<usize> offset{0};
+  std::atomic<u64> epoch{0};
+
+  auto reserve(usize bytes) -> std::byte *;
+  auto reserve_exact(usize size, usize alignment) -> void *;
+
+public:
+  concurrent_arena(usize capacity, usize sub_block_size = 64 * 1024);
+  ~concurrent_arena();
+
+  concurrent_arena(const concurrent_arena &) = delete;
+  auto operator=(const concurrent_arena &) -> concurrent_arena & = delete;
+
+  auto allocate(usize size, usize alignment) -> void *;
+  void reset();
+  auto size() const -> usize;
+  [[nodiscard]] auto valid() const noexcept -> bool { return data != nullptr; }
+};
+
 } // namespace mimalloc
 
 namespace program_scope {
@@ -109,13 +248,15 @@ public:
 
   cpp_allocator() = default;
 
+  template <class U> constexpr cpp_allocator(const cpp_allocator<U> &) {}
+
   [[nodiscard]] inline auto allocate(std::size_t n) -> T * {
     if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
       throw std::bad_array_new_length();
     }
 
-    if (auto p = static_cast<T *>(program_scope::malloc(n * sizeof(T), alignof(T)))) {
-      return p;
+    if (auto p = program_scope::malloc(n * sizeof(T), alignof(T))) {
+      return static_cast<T *>(*p);
     }
 
     throw std::bad_alloc();
@@ -124,8 +265,233 @@ public:
   void deallocate(T *, std::size_t) noexcept {}
 };
 
+template <class T, class U> auto operator==(const cpp_allocator<T> &, const cpp_allocator<U> &)
+    -> bool {
+  return true;
+}
+
+template <class T, class U> auto operator!=(const cpp_allocator<T> &, const cpp_allocator<U> &)
+    -> bool {
+  return false;
+}
+
 } // namespace program_scope
 
+namespace frame_scope {
+
+struct stats {
+  usize frame_index{0};      // Number of frame boundaries crossed so far
+  usize frame_usage{0};      // Bytes allocated during the current frame, including padding
+  usize last_frame_usage{0}; // Bytes allocated during the previous frame, including padding
+  usize high_water_mark{0};  // Largest amount of bytes allocated during a single frame
+  usize capacity{0};         // Total capacity of all frame arenas
+  usize concurrent_usage{0}; // Bytes reserved from the current frame's concurrent arena
+};
+
+auto init(usize capacity, usize redundancy = 2) -> tl::expected<void, surge::error>;
+void destroy();
+void advance();
+auto malloc(usize size, usize alignment) -> tl::expected<void *, error>;
+auto get_stats() -> stats;
+
+// Thread-safe allocation from the current frame. Unlike malloc, the shared arenas do not grow.
+auto concurrent_malloc(usize size, usize alignment) -> tl::expected<void *, error>;
+
+template <typename T> class cpp_allocator {
+public:
+  using value_type = T;
+
+  cpp_allocator() = default;
+
+  template <class U> constexpr cpp_allocator(const cpp_allocator<U> &) {}
+
+  [[nodiscard]] inline auto allocate(std::size_t n) -> T * {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+
+    if (auto p = frame_scope::malloc(n * sizeof(T), alignof(T))) {
+      return static_cast<T *>(*p);
+    }
+
+    throw std::bad_alloc();
+  }
+
+  void deallocate(T *, std::size_t) noexcept {}
+};
+
+template <class T, class U> auto operator==(const cpp_allocator<T> &, const cpp_allocator<U> &)
+    -> bool {
+  return true;
+}
+
+template <class T, class U> auto operator!=(const cpp_allocator<T> &, const cpp_allocator<U> &)
+    -> bool {
+  return false;
+}
+
+} // namespace frame_scope
+
+template <typename T> struct pool_handle {
+  u32 index{std::numeric_limits<u32>::max()};
+  u32 generation{0};
+};
+
+/*
+ * Fixed-size object pool. Objects live in cache-line-aligned blocks of BlockSize slots that are
+ * never moved or freed until the pool is destroyed, and free slots are chained in an intrusive
+ * list, so create and destroy are O(1). Handles carry the generation of their slot, which is
+ * bumped on every destroy, so stale handles are detected instead of aliasing a new object. The
+ * pool is not thread-safe.
+ */
+template <typename T, usize BlockSize = 64> class pool {
+  static_assert(BlockSize > 0, "Pool blocks must hold at least one object");
+
+public:
+  using handle = pool_handle<T>;
+
+  pool() = default;
+
+  ~pool() {
+    for (u32 i = 0; i < slot_count; i++) {
+      auto &s{slot_at(i)};
+      if (s.alive) {
+        object_at(s)->~T();
+      }
+    }
+
+    for (auto block : blocks) {
+      mimalloc::aligned_free(block, block_alignment);
+    }
+  }
+
+  pool(const pool &) = delete;
+  auto operator=(const pool &) -> pool & = delete;
+
+  template <typename... Args> auto create(Args &&...args) -> tl::expected<handle, error> {
+    if (free_head == null_index) {
+      const auto grow_error{grow()};
+      if (grow_error) {
+        return tl::unexpected{*grow_error};
+      }
+    }
+
+    const auto index{free_head};
+    auto &s{slot_at(index)};
+    free_head = s.next_free;
+
+    try {
+      ::new (static_cast<void *>(s.object)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      s.next_free = free_head;
+      free_head = index;
+      throw;
+    }
+
+    s.alive = true;
+    live_count++;
+
+    return handle{index, s.generation};
+  }
+
+  void destroy(handle h) noexcept {
+    if (!is_valid(h)) {
+      return;
+    }
+
+    auto &s{slot_at(h.index)};
+    object_at(s)->~T();
+
+    s.alive = false;
+    s.generation++;
+    s.next_free = free_head;
+    free_head = h.index;
+    live_count--;
+  }
+
+  [[nodiscard]] auto get(handle h) noexcept -> T * {
+    return is_valid(h) ? object_at(slot_at(h.index)) : nullptr;
+  }
+
+  [[nodiscard]] auto is_valid(handle h) const noexcept -> bool {
+    if (h.index >= slot_count) {
+      return false;
+    }
+
+    const auto &s{slot_at(h.index)};
+    return s.alive && s.generation == h.generation;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> usize { return live_count; }
+  [[nodiscard]] auto capacity() const noexcept -> usize { return slot_count; }
+
+private:
+  static constexpr u32 null_index{std::numeric_limits<u32>::max()};
+
+  struct slot {
+    union {
+      u32 next_free;
+      alignas(T) std::byte object[sizeof(T)];
+    };
+    u32 generation{0};
+    bool alive{false};
+  };
+
+  static constexpr usize block_alignment{alignof(slot) > cache_line_size ? alignof(slot)
+                                                                          : cache_line_size};
+
+  std::vector<slot *, mimalloc::cpp_allocator<slot *>> blocks{};
+  u32 slot_count{0};
+  u32 free_head{null_index};
+  usize live_count{0};
+
+  inline auto slot_at(u32 index) noexcept -> slot & {
+    return blocks[index / BlockSize][index % BlockSize];
+  }
+
+  inline auto slot_at(u32 index) const noexcept -> const slot & {
+    return blocks[index / BlockSize][index % BlockSize];
+  }
+
+  static inline auto object_at(slot &s) noexcept -> T * {
+    return std::launder(reinterpret_cast<T *>(s.object));
+  }
+
+  auto grow() -> std::optional<error> {
+    if (BlockSize > static_cast<usize>(null_index - slot_count)) {
+      return error::pool_block_alloc;
+    }
+
+    // Pools outlive the module heaps that may be active when they grow
+    const mimalloc::heap_scope engine_heap{mimalloc::heap_get_backing()};
+
+    // Make room for the block pointer first, so a throwing push_back cannot leak the block
+    if (blocks.size() == blocks.capacity()) {
+      blocks.reserve(blocks.empty() ? 1 : blocks.size() * 2);
+    }
+
+    auto block{static_cast<slot *>(
+        mimalloc::aligned_alloc(sizeof(slot) * BlockSize, block_alignment))};
+    if (block == nullptr) {
+      return error::pool_block_alloc;
+    }
+
+    blocks.push_back(block);
+
+    // Chain the new slots in index order in front of the (empty) free list
+    const auto first{slot_count};
+    for (usize i = 0; i < BlockSize; i++) {
+      auto s{::new (static_cast<void *>(&block[i])) slot{}};
+      s->next_free = (i + 1 == BlockSize) ? free_head : static_cast<u32>(first + i + 1);
+    }
+
+    slot_count += static_cast<u32>(BlockSize);
+    free_head = first;
+
+    return {};
+  }
+};
+
 } // namespace surge::allocators
 
 #endif // SURGE_CORE_ALLOCATORS_HPP
\ No newline at end of file
@@ -0,0 +1,121 @@
+#ifndef SURGE_CORE_ARCHIVE_HPP
+#define SURGE_CORE_ARCHIVE_HPP
+
+#include "sc_container_types.hpp"
+#include "sc_error_types.hpp"
+#include "sc_files.hpp"
+#include "sc_integer_types.hpp"
+
+#include <optional>
+#include <span>
+#include <string_view>
+#include <tl/expected.hpp>
+
+/*
+ * SURGE asset packs (.spk). A pack stores many assets in one file, so loading them costs a single
+ * open and mmap instead of several syscalls per asset. A pack is laid out as
+ * - an archive_header
+ * - entry_count archive_entry records, sorted by name hash
+ * - the name table, holding the path each entry was packed from
+ * - the payloads, each starting at a multiple of the header alignment
+ * Compressed payloads are split in chunks of chunk_size decompressed bytes, the last one possibly
+ * shorter, each compressed on its own so they can be decompressed in parallel. They start with a
+ * table holding the end of every compressed chunk, as u64 offsets from the end of the table,
+ * followed by the chunks. All integers are little endian. Packs are built with the surge_pack tool.
+ */
+namespace surge::files {
+
+// LZ4 decompresses fastest, Zstd makes smaller packs
+enum class compression : u32 { none, lz4, zstd };
+
+// Decompressed bytes per chunk surge_pack uses by default
+inline constexpr u32 default_chunk_size{256 * 1024};
+
+struct archive_header {
+  char magic[4]{'S', 'P', 'K', 'A'};
+  u32 version{1};
+  u64 entry_count{0};
+  u64 index_offset{0}; // Position of the first entry from the start of the pack
+  u64 names_offset{0}; // Position of the name table from the start of the pack
+  u32 entry_size{48};
+  u32 alignment{64};
+};
+
+struct archive_entry {
+  u64 name_hash{0};   // archive_hash() of the name
+  u64 offset{0};      // Position of the payload from the start of the pack
+  u64 stored_size{0}; // Payload size in the pack
+  u64 size{0};        // Payload size once decompressed
+  u32 name_offset{0}; // Position of the name in the name table
+  u32 name_length{0};
+  compression method{compression::none};
+  u32 chunk_size{0}; // Decompressed bytes per chunk, 0 for uncompressed entries
+};
+
+static_assert(sizeof(archive_header) == 40, "Pack headers must be 40 bytes long");
+static_assert(sizeof(archive_entry) == 48, "Pack entries must be 48 bytes long");
+
+// Entries are keyed by the XXH64 of the path they were packed from, as written to the name table
+auto archive_hash(std::string_view name) noexcept -> u64;
+
+/**
+ * @brief Compresses bytes with method, returning the payload as stored in a pack. Chunks are
+ * compressed in parallel, at the codec's high compression levels since packs are built offline.
+ */
+auto compress_payload(compression method, u32 chunk_size, std::span<const std::byte> bytes)
+    -> tl::expected<vector<std::byte>, error>;
+
+/**
+ * @brief Decompresses a payload made by compress_payload into out, which must have the exact
+ * decompressed size. Chunks are decompressed in parallel, on the executor run_and_wait() picks
+ * for the calling thread. Called from a background worker, chunks yield to the frame.
+ */
+auto decompress_payload(compression method, u32 chunk_size, std::span<const std::byte> payload,
+                        std::span<std::byte> out) -> std::optional<error>;
+
+/*
+ * Read only view of a pack. The whole pack is mapped once and entries are found by a binary
+ * search of the index. Views handed out by map() for uncompressed entries point into the pack
+ * mapping and must not outlive the archive. Compressed entries are decompressed into a buffer the
+ * returned mapping owns.
+ */
+class archive {
+private:
+  mapped_file pack{};
+  std::span<const archive_entry> index{};
+  std::span<const char> names{};
+
+public:
+  static auto open(const char *path) -> tl::expected<archive, error>;
+
+  [[nodiscard]] auto find(std::string_view name) const noexcept -> const archive_entry *;
+  [[nodiscard]] auto name(const archive_entry &e) const noexcept -> std::string_view;
+  [[nodiscard]] auto payload(const archive_entry &e) const noexcept -> std::span<const std::byte>;
+  [[nodiscard]] auto entries() const noexcept -> std::span<const archive_entry> { return index; }
+
+  auto read(const archive_entry &e, bool append_null_byte) const -> file;
+  auto map(const archive_entry &e) const -> mapping;
+
+  auto load_file(std::string_view name, bool append_null_byte) const -> file;
+  auto map_file(std::string_view name) const -> mapping;
+  auto load_image(const char *name, bool flip = true) const -> image;
+};
+
+/*
+ * Mounted packs. load_file, load_file_async, map_file and load_image look paths up in the mounted
+ * packs, the most recently mounted first, before going to the file system. Packs are mounted and
+ * unmounted from the main thread while no loads are running, and stay mapped until unmounted.
+ */
+auto mount(const char *path) -> std::optional<error>;
+void unmount_all();
+
+struct mounted_entry {
+  const archive *pack{nullptr};
+  const archive_entry *entry{nullptr};
+};
+
+auto find_mounted(std::string_view name) noexcept -> std::optional<mounted_entry>;
+
+} // namespace surge::files
+
+#endif // SURGE_CORE_ARCHIVE_HPP
\ No newline at end of file
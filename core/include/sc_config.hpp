@@ -3,7 +3,9 @@
 
 #include "sc_container_types.hpp"
 #include "sc_error_types.hpp"
+#include "sc_integer_types.hpp"
 
+#include <bitset>
 #include <tl/expected.hpp>
 
 namespace surge::config {
@@ -21,7 +23,7 @@ struct clear_color {
 };
 
 struct window_attrs {
-  string name{"SURGE Window"};
+  inline_string<64> name{"SURGE Window"};
   int monitor_index{0};
   bool windowed{true};
   bool cursor{true};
@@ -37,12 +39,46 @@ struct renderer_attrs {
   int fps_cap_value{60};
 };
 
+struct memory_attrs {
+  bool huge_pages{false};              // Back the arena memory with large OS pages
+  usize arena_memory_size{0};          // Bytes reserved for engine arenas. 0 disables it
+  usize frame_arena_size{1024 * 1024}; // Initial capacity of each frame arena in bytes
+};
+
+// Smaller frame arena sizes in config.yaml are raised to this
+inline constexpr usize min_frame_arena_size{4 * 1024};
+
+// Larger arena sizes in config.yaml are lowered to these. They also keep the unit conversions from
+// overflowing
+inline constexpr usize max_arena_memory_size{usize{1} << 40};
+inline constexpr usize max_frame_arena_size{usize{1} << 30};
+
+// Highest CPU index that can appear in an affinity list
+inline constexpr usize max_cpus{256};
+using cpu_set = std::bitset<max_cpus>;
+
+enum class thread_priority { low, normal, high };
+
+struct executor_attrs {
+  usize worker_count{0};           // 0 picks one worker per available core
+  bool physical_cores_only{false}; // Ignore SMT siblings when picking the worker count
+  int main_thread_core{-1};        // Core reserved for the main thread. -1 leaves it unpinned
+  cpu_set worker_cpus{};           // Cores workers may run on. Empty means all but the main one
+  bool pin_workers{false};         // Pin each worker to a single core instead of the whole set
+  thread_priority worker_priority{thread_priority::normal};
+  usize normal_workers{0};        // Workers for normal jobs. 0 uses half the frame workers
+  usize background_workers{0};    // Workers for background jobs. 0 uses a quarter of them
+  double background_yield{0.002}; // Seconds before the frame deadline background jobs yield
+};
+
 struct config_data {
   window_resolution wr{};
   clear_color ccl{};
   window_attrs wattrs{};
   renderer_attrs rattrs{};
-  string module{};
+  inline_string<128> module{};
+  memory_attrs mattrs{};
+  executor_attrs eattrs{};
 };
 
 auto parse_config(renderer_backend backend) -> tl::expected<config_data, error>;
@@ -2,6 +2,9 @@
 #define SURGE_CORE_CONTAINER_TYPES_HPP
 
 #include "sc_allocators.hpp"
+#include "sc_flat_hash_map.hpp"
+#include "sc_small_containers.hpp"
+#include "sc_soa_vector.hpp"
 
 #include <array>
 #include <deque>
@@ -22,8 +25,47 @@ template <typename T> using queue = std::queue<T, deque<T>>;
 template <typename T, std::size_t N> using array = std::array<T, N>;
 using string = std::basic_string<char, std::char_traits<char>, cpp_mimalloc<char>>;
 
+// Inline storage for the first N elements or characters, heap storage past that
+template <typename T, usize N> using small_vector = containers::small_vector<T, N, cpp_mimalloc<T>>;
+template <usize N> using inline_string = containers::basic_inline_string<N, cpp_mimalloc<char>>;
+
+// One cache line aligned column per field
+template <typename... Fields> using soa_vector = containers::soa_vector<Fields...>;
+
+/*
+ * Containers backed by the engine's scoped allocators. They never free individual allocations:
+ * their memory, including buffers abandoned while growing, is reclaimed all at once when the
+ * backing arena is reset. Arena containers take the arena on construction, e.g.
+ * arena_vector<int> v{&a}. Frame containers must not outlive the frame they were created in.
+ */
+template <typename T> using arena_allocator = allocators::mimalloc::arena_cpp_allocator<T>;
+template <typename T> using frame_allocator = allocators::frame_scope::cpp_allocator<T>;
+template <typename T> using program_allocator = allocators::program_scope::cpp_allocator<T>;
+
+template <typename T> using arena_vector = std::vector<T, arena_allocator<T>>;
+template <typename T> using frame_vector = std::vector<T, frame_allocator<T>>;
+template <typename T> using program_vector = std::vector<T, program_allocator<T>>;
+
+template <typename Key, typename Value, template <typename> typename Allocator>
+using scoped_hash_map
+    = containers::flat_hash_map<Key, Value, containers::default_hash<Key>,
+                                containers::default_key_equal<Key>,
+                                Allocator<std::pair<const Key, Value>>>;
+
+template <typename Key, typename Value> using arena_hash_map
+    = scoped_hash_map<Key, Value, arena_allocator>;
+template <typename Key, typename Value> using frame_hash_map
+    = scoped_hash_map<Key, Value, frame_allocator>;
+
 template <typename Key, typename Value> using hash_map
-    = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+    = containers::flat_hash_map<Key, Value, containers::default_hash<Key>,
+                                containers::default_key_equal<Key>,
+                                cpp_mimalloc<std::pair<const Key, Value>>>;
+
+// Node based map, for the rare cases where references must survive insertions
+template <typename Key, typename Value> using node_hash_map
+    = std::unordered_map<Key, Value, containers::default_hash<Key>,
+                         containers::default_key_equal<Key>,
                          cpp_mimalloc<std::pair<const Key, Value>>>;
 
 } // namespace surge
@@ -0,0 +1,183 @@
+#ifndef SURGE_CORE_ECS_HPP
+#define SURGE_CORE_ECS_HPP
+
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_opengl/atoms/sprite_database.hpp"
+#include "sc_opengl/atoms/text.hpp"
+#include "sc_tasks.hpp"
+
+#include <entt/entity/registry.hpp>
+#include <functional>
+#include <glm/glm.hpp>
+#include <string_view>
+#include <tuple>
+
+/**
+ * @brief Entity component system built on EnTT's sparse sets. Components of one type are packed
+ * together, so systems stream over exactly the data they touch instead of chasing per-object
+ * state kept in module globals.
+ */
+namespace surge::ecs {
+
+using entity = entt::entity;
+using registry_t = entt::basic_registry<entity, cpp_mimalloc<entity>>;
+
+/*
+ * Components
+ */
+struct transform {
+  glm::vec3 position{0.0f};
+  glm::vec2 scale{1.0f};
+  float rotation{0.0f}; // Radians, around the z axis
+};
+
+struct sprite {
+  GLuint64 texture_handle{0};
+  glm::vec4 color_mod{1.0f};
+  glm::vec4 view{1.0f, 1.0f, 0.0f, 0.0f}; // See gl_atom::sprite_database::make_view
+  bool visible{true};
+};
+
+// Drawn with the transform position as the baseline origin
+struct text {
+  inline_string<32> contents{};
+  gl_atom::text::glyph_cache *cache{nullptr};
+};
+
+auto model_matrix(const transform &t) noexcept -> glm::mat4;
+
+/*
+ * Registry
+ */
+class registry {
+private:
+  registry_t reg{};
+
+public:
+  auto create() -> entity { return reg.create(); }
+  void destroy(entity e) { reg.destroy(e); }
+  void clear() { reg.clear(); }
+
+  [[nodiscard]] auto valid(entity e) const -> bool { return reg.valid(e); }
+
+  template <typename Component, typename... Args>
+  auto emplace(entity e, Args &&...args) -> decltype(auto) {
+    return reg.emplace<Component>(e, std::forward<Args>(args)...);
+  }
+
+  template <typename... Components> void remove(entity e) { reg.remove<Components...>(e); }
+
+  template <typename... Components> [[nodiscard]] auto get(entity e) -> decltype(auto) {
+    return reg.get<Components...>(e);
+  }
+
+  template <typename... Components> [[nodiscard]] auto all_of(entity e) const -> bool {
+    return reg.all_of<Components...>(e);
+  }
+
+  template <typename... Components> [[nodiscard]] auto view() {
+    return reg.view<Components...>();
+  }
+
+  // Direct access for anything the wrapper does not cover
+  [[nodiscard]] auto raw() noexcept -> registry_t & { return reg; }
+};
+
+/*
+ * Parallel iteration
+ */
+
+// Entities handled by a single task when splitting a view
+inline constexpr usize default_grain{1024};
+
+/**
+ * @brief Calls f(entity, Lead &, Others &...) for every entity owning all the given components,
+ * splitting the work across the executor.
+ *
+ * Entities are taken from the packed array of Lead, so list the rarest component first. f may
+ * write to the components it receives but must not create or destroy entities, nor add or remove
+ * components. Components must not be empty types.
+ */
+template <typename Lead, typename... Others, typename F>
+void parallel_each(registry &reg, F &&f, usize grain = default_grain) {
+  // Pools are fetched here, since fetching one for the first time inserts it in the registry
+  auto &lead{reg.raw().storage<Lead>()};
+  auto others{std::forward_as_tuple(reg.raw().storage<Others>()...)};
+
+  const auto entities{lead.data()};
+
+  std::apply(
+      [&](auto &...pools) {
+        tasks::parallel_for(0, lead.size(), grain, [&](usize i) {
+          const auto e{entities[i]};
+          if (e != entt::tombstone && (pools.contains(e) && ...)) {
+            f(e, lead.get(e), pools.get(e)...);
+          }
+        });
+      },
+      others);
+}
+
+/*
+ * Systems
+ */
+
+/**
+ * @brief Runs systems in stages. Stages run in increasing order, and the systems of one stage run
+ * in parallel on the executor. Systems sharing a stage must not write components another one of
+ * them touches, and structural changes (creating or destroying entities, adding or removing
+ * components) are only safe from a system that is alone in its stage.
+ *
+ * The task graph is built on the first run after a change and reused every frame after that.
+ */
+class scheduler {
+public:
+  using system = std::function<void(registry &, double)>;
+
+  scheduler() = default;
+  scheduler(const scheduler &) = delete;
+  scheduler(scheduler &&) = delete;
+  auto operator=(const scheduler &) -> scheduler & = delete;
+  auto operator=(scheduler &&) -> scheduler & = delete;
+  ~scheduler() = default;
+
+  void add(u32 stage, std::string_view name, system s);
+  void clear();
+
+  void run(registry &reg, double dt);
+
+private:
+  struct entry {
+    u32 stage{0};
+    string name{};
+    system fn{};
+  };
+
+  vector<entry> systems{};
+
+  tf::Taskflow graph{};
+  bool graph_dirty{true};
+
+  // Arguments of the run in progress, read by the cached graph
+  registry *current_reg{nullptr};
+  double current_dt{0.0};
+
+  void build_graph();
+};
+
+/*
+ * Built-in systems
+ */
+
+// Writes every visible entity with a transform and a sprite straight into the database
+void feed_sprites(registry &reg, gl_atom::sprite_database::database sdb,
+                  usize grain = default_grain);
+
+// Pushes every entity with a transform and a text into the buffer. Runs serially
+void feed_text(registry &reg, gl_atom::text::text_buffer &buffer);
+
+} // namespace surge::ecs
+
+#endif // SURGE_CORE_ECS_HPP
\ No newline at end of file
@@ -12,17 +12,22 @@ enum error : int {
   dynamic_arena_init,
   dynamic_arena_alloc,
   dynamic_arena_grow,
+  pool_block_alloc,
+  memory_trace_open,
+  arena_memory_reserve,
 
   // File errors
   invalid_path,
   read_error,
   invalid_format,
   unknow_error,
+  compression_error,
 
   // Module errors
   loading,
   name_retrival,
   symbol_retrival,
+  update_graph_build,
 
   // Renderer errors,
   unrecognized_shader,
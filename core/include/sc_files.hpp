@@ -5,6 +5,9 @@
 #include "sc_error_types.hpp"
 #include "sc_tasks.hpp"
 
+#include <functional>
+#include <future>
+#include <span>
 #include <tl/expected.hpp>
 
 namespace surge::files {
@@ -15,7 +18,82 @@ using file = tl::expected<file_data_t, error>;
 
 auto validate_path(const char *path) -> bool;
 
-auto load_file(const char *path, bool append_null_byte) -> file;
+/*
+ * How load_file reads. Direct reads bypass the OS page cache, which avoids evicting everything
+ * else when streaming huge asset packs that are read once. They fall back to cached reads where
+ * the file system or OS does not support them.
+ */
+enum class io_mode { cached, direct };
+
+auto load_file(const char *path, bool append_null_byte, io_mode mode = io_mode::cached) -> file;
+
+/*
+ * Asynchronous whole file reads. On Linux, reads are batched and submitted through io_uring by a
+ * dedicated IO thread, in chunks, so many assets are in flight at once with few syscalls. Where
+ * io_uring is not available each file is read with load_file on a worker instead. Either way,
+ * on_complete runs on an executor worker of class p as soon as the file is in memory, so parsing
+ * or decoding starts right away. Reads in flight hold their callbacks, so a module must wait for
+ * its reads before it is unloaded.
+ */
+enum class io_backend { io_uring, blocking };
+
+using file_future = std::future<file>;
+using file_callback = std::function<void(file)>;
+using batch_callback = std::function<void(usize, file)>;
+
+auto get_io_backend() -> io_backend;
+
+void load_file_async(const char *path, bool append_null_byte, file_callback on_complete,
+                     tasks::priority p = tasks::priority::background);
+
+// Submits every read at once. on_complete receives the index of each path as it completes
+void load_files_async(std::span<const char *const> paths, bool append_null_byte,
+                      batch_callback on_complete, tasks::priority p = tasks::priority::background);
+
+auto load_file_task(const char *path, bool append_null_byte,
+                    tasks::priority p = tasks::priority::background) -> file_future;
+
+/*
+ * Read only memory mapping of a whole file, unmapped on destruction. Pages are read by the OS as
+ * they are touched, so parsers can work on the file contents without copying them into a buffer
+ * first. The mapping is page aligned and not null terminated. Empty files map to an empty span.
+ * Files served from a mounted archive are views into the archive mapping instead, or own their
+ * decompressed contents when the archive entry is compressed, see sc_archive.hpp.
+ */
+class mapped_file {
+private:
+  const std::byte *ptr{nullptr};
+  usize len{0};
+  bool borrowed{false};
+  file_data_t owned{};
+
+  mapped_file(const std::byte *p, usize size, bool borrowed_view) noexcept;
+  explicit mapped_file(file_data_t &&buffer) noexcept;
+  friend auto map_file(const char *path) -> tl::expected<mapped_file, error>;
+  friend class archive;
+
+public:
+  mapped_file() noexcept = default;
+  ~mapped_file();
+
+  mapped_file(const mapped_file &) = delete;
+  auto operator=(const mapped_file &) -> mapped_file & = delete;
+
+  mapped_file(mapped_file &&other) noexcept;
+  auto operator=(mapped_file &&other) noexcept -> mapped_file &;
+
+  [[nodiscard]] auto data() const noexcept -> const std::byte * { return ptr; }
+  [[nodiscard]] auto size() const noexcept -> usize { return len; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return len == 0; }
+  [[nodiscard]] auto view() const noexcept -> std::span<const std::byte> { return {ptr, len}; }
+};
+
+using mapping = tl::expected<mapped_file, error>;
+
+/*
+ * Maps a file for reading, hinting the OS to read it ahead sequentially.
+ */
+auto map_file(const char *path) -> mapping;
 
 struct image_data {
   int width;
@@ -37,6 +115,7 @@ using openEXR_image = tl::expected<openEXR_image_data, error>;
 using img_future = std::future<image>;
 
 auto load_image(const char *path, bool flip = true) -> image;
+auto decode_image(const char *name, std::span<const std::byte> bytes, bool flip = true) -> image;
 auto load_image_task(const char *path, bool flip = true) -> img_future;
 void free_image(image_data &);
 void free_image_task(image_data &);
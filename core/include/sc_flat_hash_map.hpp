@@ -0,0 +1,697 @@
+#ifndef SURGE_CORE_FLAT_HASH_MAP_HPP
+#define SURGE_CORE_FLAT_HASH_MAP_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define SURGE_FLAT_HASH_MAP_SSE2
+#endif
+
+namespace surge::containers {
+
+/*
+ * Hash used for string keys. It is transparent, so maps keyed by strings can be queried with
+ * std::string_view or const char * without building a temporary key.
+ */
+struct string_hash {
+  using is_transparent = void;
+
+  auto operator()(std::string_view s) const noexcept -> usize {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
+// std::string_view and std::basic_string<char> with any allocator
+template <typename Key> concept string_key
+    = std::is_same_v<Key, std::string_view> || requires {
+        typename Key::traits_type;
+        typename Key::allocator_type;
+        requires std::is_same_v<typename Key::value_type, char>;
+      };
+
+template <typename Key> using default_hash
+    = std::conditional_t<string_key<Key>, string_hash, std::hash<Key>>;
+
+template <typename Key> using default_key_equal
+    = std::conditional_t<string_key<Key>, std::equal_to<>, std::equal_to<Key>>;
+
+template <typename Hash, typename KeyEqual> concept transparent_lookup = requires {
+  typename Hash::is_transparent;
+  typename KeyEqual::is_transparent;
+};
+
+namespace detail {
+
+/*
+ * Control bytes. A full slot stores the low 7 bits of its hash (H2), so the high bit tells free
+ * slots apart from full ones.
+ */
+inline constexpr u8 ctrl_empty{0x80};
+inline constexpr u8 ctrl_deleted{0xFE};
+
+inline constexpr usize group_size{16};
+
+// Bit i is set when byte i of the probed group matches
+class bitmask {
+private:
+  u32 mask{0};
+
+public:
+  constexpr explicit bitmask(u32 m) noexcept : mask{m} {}
+
+  [[nodiscard]] constexpr auto any() const noexcept -> bool { return mask != 0; }
+  [[nodiscard]] constexpr auto lowest() const noexcept -> usize {
+    return static_cast<usize>(std::countr_zero(mask));
+  }
+  constexpr void clear_lowest() noexcept { mask &= mask - 1; }
+};
+
+// Sixteen control bytes compared at once, with SSE2 where available
+class group {
+private:
+#ifdef SURGE_FLAT_HASH_MAP_SSE2
+  __m128i ctrl;
+#else
+  std::array<u8, group_size> ctrl{};
+#endif
+
+public:
+  explicit group(const u8 *p) noexcept {
+#ifdef SURGE_FLAT_HASH_MAP_SSE2
+    ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+#else
+    std::memcpy(ctrl.data(), p, group_size);
+#endif
+  }
+
+  [[nodiscard]] auto match(u8 h2) const noexcept -> bitmask {
+#ifdef SURGE_FLAT_HASH_MAP_SSE2
+    const auto eq{_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(h2)), ctrl)};
+    return bitmask{static_cast<u32>(_mm_movemask_epi8(eq))};
+#else
+    u32 m{0};
+    for (usize i = 0; i < group_size; i++) {
+      m |= static_cast<u32>(ctrl[i] == h2) << i;
+    }
+    return bitmask{m};
+#endif
+  }
+
+  [[nodiscard]] auto match_empty() const noexcept -> bitmask { return match(ctrl_empty); }
+
+  [[nodiscard]] auto match_free() const noexcept -> bitmask {
+#ifdef SURGE_FLAT_HASH_MAP_SSE2
+    return bitmask{static_cast<u32>(_mm_movemask_epi8(ctrl))};
+#else
+    u32 m{0};
+    for (usize i = 0; i < group_size; i++) {
+      m |= static_cast<u32>(ctrl[i] >> 7) << i;
+    }
+    return bitmask{m};
+#endif
+  }
+};
+
+/*
+ * std::hash is the identity for integers on common standard libraries, which would leave H2 equal
+ * to the high bits of small keys. The murmur3 finalizer spreads every input bit over the result.
+ */
+constexpr auto mix_hash(usize h) noexcept -> u64 {
+  auto x{static_cast<u64>(h)};
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+} // namespace detail
+
+/*
+ * Open addressing hash map laid out as in Swiss tables: a flat array of slots plus one control
+ * byte per slot, probed a group of sixteen control bytes at a time. Lookups touch the control
+ * bytes and at most a few candidate slots instead of chasing bucket nodes.
+ *
+ * Unlike std::unordered_map, rehashing moves the elements, so inserting may invalidate iterators,
+ * pointers and references. Erasing only invalidates the erased element. Capacity is always a power
+ * of two of at least sixteen slots, and the map grows once it is 7/8 full.
+ */
+template <typename Key, typename Value, typename Hash = default_hash<Key>,
+          typename KeyEqual = default_key_equal<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class flat_hash_map {
+public:
+  using key_type = Key;
+  using mapped_type = Value;
+  using value_type = std::pair<const Key, Value>;
+  using size_type = usize;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+  using allocator_type = Allocator;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+
+private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+  using slot_allocator = typename alloc_traits::template rebind_alloc<value_type>;
+  using slot_traits = std::allocator_traits<slot_allocator>;
+  using ctrl_allocator = typename alloc_traits::template rebind_alloc<u8>;
+  using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+
+  static constexpr usize min_capacity{detail::group_size};
+
+  u8 *ctrl{nullptr};
+  value_type *slots{nullptr};
+  usize slot_count{0};
+  usize element_count{0};
+  usize growth_left{0};
+
+  [[no_unique_address]] Hash hash_fn{};
+  [[no_unique_address]] KeyEqual key_eq{};
+  [[no_unique_address]] slot_allocator alloc{};
+
+  template <bool is_const> class iterator_base {
+  private:
+    friend class flat_hash_map;
+    template <bool> friend class iterator_base;
+
+    using element_t = flat_hash_map::value_type;
+    using slot_ptr = std::conditional_t<is_const, const element_t *, element_t *>;
+
+    const u8 *ctrl{nullptr};
+    const u8 *ctrl_end{nullptr};
+    slot_ptr slot{nullptr};
+
+    iterator_base(const u8 *c, const u8 *c_end, slot_ptr s) noexcept
+        : ctrl{c}, ctrl_end{c_end}, slot{s} {
+      skip_free();
+    }
+
+    void skip_free() noexcept {
+      while (ctrl != ctrl_end && (*ctrl & detail::ctrl_empty) != 0) {
+        ctrl++;
+        slot++;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = element_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = slot_ptr;
+    using reference = std::conditional_t<is_const, const element_t &, element_t &>;
+
+    iterator_base() noexcept = default;
+
+    // iterator converts to const_iterator
+    template <bool other_const>
+      requires(is_const && !other_const)
+    iterator_base(const iterator_base<other_const> &other) noexcept
+        : ctrl{other.ctrl}, ctrl_end{other.ctrl_end}, slot{other.slot} {}
+
+    auto operator*() const noexcept -> reference { return *slot; }
+    auto operator->() const noexcept -> pointer { return slot; }
+
+    auto operator++() noexcept -> iterator_base & {
+      ctrl++;
+      slot++;
+      skip_free();
+      return *this;
+    }
+
+    auto operator++(int) noexcept -> iterator_base {
+      auto tmp{*this};
+      ++(*this);
+      return tmp;
+    }
+
+    friend auto operator==(const iterator_base &a, const iterator_base &b) noexcept -> bool {
+      return a.ctrl == b.ctrl;
+    }
+  };
+
+public:
+  using iterator = iterator_base<false>;
+  using const_iterator = iterator_base<true>;
+
+  flat_hash_map() noexcept = default;
+
+  explicit flat_hash_map(usize capacity, const Hash &hash = Hash{},
+                         const KeyEqual &equal = KeyEqual{}, const Allocator &a = Allocator{})
+      : hash_fn{hash}, key_eq{equal}, alloc{a} {
+    reserve(capacity);
+  }
+
+  explicit flat_hash_map(const Allocator &a) noexcept : alloc{a} {}
+
+  flat_hash_map(const flat_hash_map &other)
+      : hash_fn{other.hash_fn},
+        key_eq{other.key_eq},
+        alloc{slot_traits::select_on_container_copy_construction(other.alloc)} {
+    reserve(other.element_count);
+    for (const auto &v : other) {
+      insert_unique(v.first, v.second);
+    }
+  }
+
+  flat_hash_map(flat_hash_map &&other) noexcept
+      : ctrl{std::exchange(other.ctrl, nullptr)},
+        slots{std::exchange(other.slots, nullptr)},
+        slot_count{std::exchange(other.slot_count, 0)},
+        element_count{std::exchange(other.element_count, 0)},
+        growth_left{std::exchange(other.growth_left, 0)},
+        hash_fn{std::move(other.hash_fn)},
+        key_eq{std::move(other.key_eq)},
+        alloc{std::move(other.alloc)} {}
+
+  auto operator=(const flat_hash_map &other) -> flat_hash_map & {
+    if (this != &other) {
+      auto copy{other};
+      swap(copy);
+    }
+    return *this;
+  }
+
+  auto operator=(flat_hash_map &&other) noexcept -> flat_hash_map & {
+    if (this != &other) {
+      release();
+      ctrl = std::exchange(other.ctrl, nullptr);
+      slots = std::exchange(other.slots, nullptr);
+      slot_count = std::exchange(other.slot_count, 0);
+      element_count = std::exchange(other.element_count, 0);
+      growth_left = std::exchange(other.growth_left, 0);
+      hash_fn = std::move(other.hash_fn);
+      key_eq = std::move(other.key_eq);
+      alloc = std::move(other.alloc);
+    }
+    return *this;
+  }
+
+  ~flat_hash_map() noexcept { release(); }
+
+  void swap(flat_hash_map &other) noexcept {
+    using std::swap;
+    swap(ctrl, other.ctrl);
+    swap(slots, other.slots);
+    swap(slot_count, other.slot_count);
+    swap(element_count, other.element_count);
+    swap(growth_left, other.growth_left);
+    swap(hash_fn, other.hash_fn);
+    swap(key_eq, other.key_eq);
+    swap(alloc, other.alloc);
+  }
+
+  [[nodiscard]] auto get_allocator() const noexcept -> allocator_type {
+    return allocator_type{alloc};
+  }
+
+  /*
+   * Iteration
+   */
+  [[nodiscard]] auto begin() noexcept -> iterator { return {ctrl, ctrl + slot_count, slots}; }
+  [[nodiscard]] auto end() noexcept -> iterator {
+    return {ctrl + slot_count, ctrl + slot_count, slots + slot_count};
+  }
+
+  [[nodiscard]] auto begin() const noexcept -> const_iterator {
+    return {ctrl, ctrl + slot_count, slots};
+  }
+  [[nodiscard]] auto end() const noexcept -> const_iterator {
+    return {ctrl + slot_count, ctrl + slot_count, slots + slot_count};
+  }
+
+  [[nodiscard]] auto cbegin() const noexcept -> const_iterator { return begin(); }
+  [[nodiscard]] auto cend() const noexcept -> const_iterator { return end(); }
+
+  /*
+   * Capacity
+   */
+  [[nodiscard]] auto size() const noexcept -> usize { return element_count; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return element_count == 0; }
+  [[nodiscard]] auto capacity() const noexcept -> usize { return slot_count; }
+
+  [[nodiscard]] auto load_factor() const noexcept -> float {
+    return slot_count == 0 ? 0.0f
+                           : static_cast<float>(element_count) / static_cast<float>(slot_count);
+  }
+
+  // Makes room for count elements, so that inserting them does not rehash
+  void reserve(usize count) {
+    if (count > element_count + growth_left) {
+      rehash(capacity_for(count));
+    }
+  }
+
+  // Destroys the elements but keeps the storage
+  void clear() noexcept {
+    if (element_count != 0) {
+      for (usize i = 0; i < slot_count; i++) {
+        if (is_full(ctrl[i])) {
+          slot_traits::destroy(alloc, slots + i);
+        }
+      }
+    }
+
+    if (slot_count != 0) {
+      std::memset(ctrl, detail::ctrl_empty, slot_count);
+    }
+    element_count = 0;
+    growth_left = max_load(slot_count);
+  }
+
+  /*
+   * Lookup
+   */
+  [[nodiscard]] auto find(const Key &key) noexcept -> iterator { return to_iter(find_index(key)); }
+  [[nodiscard]] auto find(const Key &key) const noexcept -> const_iterator {
+    return to_iter(find_index(key));
+  }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+  [[nodiscard]] auto find(const K &key) noexcept -> iterator {
+    return to_iter(find_index(key));
+  }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+  [[nodiscard]] auto find(const K &key) const noexcept -> const_iterator {
+    return to_iter(find_index(key));
+  }
+
+  [[nodiscard]] auto contains(const Key &key) const noexcept -> bool {
+    return find_index(key) != slot_count;
+  }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+  [[nodiscard]] auto contains(const K &key) const noexcept -> bool {
+    return find_index(key) != slot_count;
+  }
+
+  [[nodiscard]] auto count(const Key &key) const noexcept -> usize { return contains(key) ? 1 : 0; }
+
+  [[nodiscard]] auto at(const Key &key) -> Value & { return at_impl(key); }
+  [[nodiscard]] auto at(const Key &key) const -> const Value & {
+    return const_cast<flat_hash_map *>(this)->at_impl(key);
+  }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+  [[nodiscard]] auto at(const K &key) -> Value & {
+    return at_impl(key);
+  }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+  [[nodiscard]] auto at(const K &key) const -> const Value & {
+    return const_cast<flat_hash_map *>(this)->at_impl(key);
+  }
+
+  /*
+   * Modifiers
+   */
+  auto operator[](const Key &key) -> Value & { return try_emplace(key).first->second; }
+  auto operator[](Key &&key) -> Value & { return try_emplace(std::move(key)).first->second; }
+
+  template <typename K, typename... Args>
+    requires std::is_constructible_v<Key, K &&>
+  auto try_emplace(K &&key, Args &&...args) -> std::pair<iterator, bool> {
+    const auto hash{hash_of(key)};
+    if (const auto idx{find_index(key, hash)}; idx != slot_count) {
+      return {to_iter(idx), false};
+    }
+
+    const auto idx{prepare_insert(hash)};
+    slot_traits::construct(alloc, slots + idx, std::piecewise_construct,
+                           std::forward_as_tuple(std::forward<K>(key)),
+                           std::forward_as_tuple(std::forward<Args>(args)...));
+    return {to_iter(idx), true};
+  }
+
+  template <typename K, typename V>
+    requires std::is_constructible_v<Key, K &&>
+  auto insert_or_assign(K &&key, V &&value) -> std::pair<iterator, bool> {
+    auto result{try_emplace(std::forward<K>(key), std::forward<V>(value))};
+    if (!result.second) {
+      result.first->second = std::forward<V>(value);
+    }
+    return result;
+  }
+
+  auto insert(const value_type &value) -> std::pair<iterator, bool> {
+    return try_emplace(value.first, value.second);
+  }
+
+  auto insert(value_type &&value) -> std::pair<iterator, bool> {
+    return try_emplace(std::move(const_cast<Key &>(value.first)), std::move(value.second));
+  }
+
+  template <typename K, typename... Args> auto emplace(K &&key, Args &&...args)
+      -> std::pair<iterator, bool> {
+    return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+  }
+
+  // Returns an iterator to the element following the erased one
+  auto erase(const_iterator pos) noexcept -> iterator {
+    const auto idx{static_cast<usize>(pos.ctrl - ctrl)};
+    erase_at(idx);
+    return iterator{ctrl + idx + 1, ctrl + slot_count, slots + idx + 1};
+  }
+
+  auto erase(iterator pos) noexcept -> iterator { return erase(const_iterator{pos}); }
+
+  auto erase(const Key &key) noexcept -> usize { return erase_key(key); }
+
+  template <typename K>
+    requires transparent_lookup<Hash, KeyEqual>
+             && (!std::is_convertible_v<K, const_iterator>) && (!std::is_convertible_v<K, iterator>)
+  auto erase(const K &key) noexcept -> usize {
+    return erase_key(key);
+  }
+
+private:
+  static constexpr auto is_full(u8 c) noexcept -> bool { return (c & detail::ctrl_empty) == 0; }
+
+  static constexpr auto h1(u64 hash) noexcept -> usize { return static_cast<usize>(hash >> 7); }
+  static constexpr auto h2(u64 hash) noexcept -> u8 { return static_cast<u8>(hash & 0x7F); }
+
+  static constexpr auto max_load(usize capacity) noexcept -> usize {
+    return capacity - capacity / 8;
+  }
+
+  static constexpr auto capacity_for(usize count) noexcept -> usize {
+    const auto needed{count + (count + 6) / 7};
+    return std::bit_ceil(needed < min_capacity ? min_capacity : needed);
+  }
+
+  template <typename K> [[nodiscard]] auto hash_of(const K &key) const noexcept -> u64 {
+    return detail::mix_hash(static_cast<usize>(hash_fn(key)));
+  }
+
+  [[nodiscard]] auto to_iter(usize idx) noexcept -> iterator {
+    return iterator{ctrl + idx, ctrl + slot_count, slots + idx};
+  }
+
+  [[nodiscard]] auto to_iter(usize idx) const noexcept -> const_iterator {
+    return const_iterator{ctrl + idx, ctrl + slot_count, slots + idx};
+  }
+
+  /*
+   * Triangular probing over groups. The group count is a power of two, so the probe sequence
+   * visits every group before repeating. Returns slot_count when the key is absent.
+   */
+  template <typename K> [[nodiscard]] auto find_index(const K &key) const noexcept -> usize {
+    return find_index(key, hash_of(key));
+  }
+
+  template <typename K>
+  [[nodiscard]] auto find_index(const K &key, u64 hash) const noexcept -> usize {
+    if (slot_count == 0) {
+      return slot_count;
+    }
+
+    const auto group_mask{slot_count / detail::group_size - 1};
+    auto g{h1(hash) & group_mask};
+    const auto tag{h2(hash)};
+
+    for (usize step = 1;; step++) {
+      const auto base{g * detail::group_size};
+      const detail::group grp{ctrl + base};
+
+      for (auto m{grp.match(tag)}; m.any(); m.clear_lowest()) {
+        const auto idx{base + m.lowest()};
+        if (key_eq(slots[idx].first, key)) {
+          return idx;
+        }
+      }
+
+      if (grp.match_empty().any() || step > group_mask) {
+        return slot_count;
+      }
+
+      g = (g + step) & group_mask;
+    }
+  }
+
+  // First free slot on the probe sequence of hash, with no regard for tombstones
+  [[nodiscard]] auto find_free(u64 hash) const noexcept -> usize {
+    const auto group_mask{slot_count / detail::group_size - 1};
+    auto g{h1(hash) & group_mask};
+
+    for (usize step = 1;; step++) {
+      const auto base{g * detail::group_size};
+      const auto m{detail::group{ctrl + base}.match_free()};
+      if (m.any()) {
+        return base + m.lowest();
+      }
+      g = (g + step) & group_mask;
+    }
+  }
+
+  // Claims a slot for a new element with the given hash, growing the table when needed
+  auto prepare_insert(u64 hash) -> usize {
+    auto idx{slot_count == 0 ? slot_count : find_free(hash)};
+
+    // Reusing a tombstone does not consume growth
+    if (idx == slot_count || (growth_left == 0 && ctrl[idx] != detail::ctrl_deleted)) {
+      grow();
+      idx = find_free(hash);
+    }
+
+    if (ctrl[idx] == detail::ctrl_empty) {
+      growth_left--;
+    }
+
+    ctrl[idx] = h2(hash);
+    element_count++;
+    return idx;
+  }
+
+  // Doubles the table, or rehashes in place when tombstones take up most of the load
+  void grow() {
+    if (slot_count != 0 && element_count <= max_load(slot_count) / 2) {
+      rehash(slot_count);
+    } else {
+      rehash(slot_count == 0 ? min_capacity : slot_count * 2);
+    }
+  }
+
+  void rehash(usize new_count) {
+    ctrl_allocator c_alloc{alloc};
+    auto new_ctrl{ctrl_traits::allocate(c_alloc, new_count)};
+    value_type *new_slots{nullptr};
+    try {
+      new_slots = slot_traits::allocate(alloc, new_count);
+    } catch (...) {
+      ctrl_traits::deallocate(c_alloc, new_ctrl, new_count);
+      throw;
+    }
+
+    std::memset(new_ctrl, detail::ctrl_empty, new_count);
+
+    auto old_ctrl{std::exchange(ctrl, new_ctrl)};
+    auto old_slots{std::exchange(slots, new_slots)};
+    const auto old_count{std::exchange(slot_count, new_count)};
+
+    for (usize i = 0; i < old_count; i++) {
+      if (!is_full(old_ctrl[i])) {
+        continue;
+      }
+
+      auto &old{old_slots[i]};
+      const auto hash{hash_of(old.first)};
+      const auto idx{find_free(hash)};
+      ctrl[idx] = h2(hash);
+      slot_traits::construct(alloc, slots + idx, std::piecewise_construct,
+                             std::forward_as_tuple(std::move(const_cast<Key &>(old.first))),
+                             std::forward_as_tuple(std::move(old.second)));
+      slot_traits::destroy(alloc, &old);
+    }
+
+    growth_left = max_load(slot_count) - element_count;
+
+    if (old_count != 0) {
+      ctrl_traits::deallocate(c_alloc, old_ctrl, old_count);
+      slot_traits::deallocate(alloc, old_slots, old_count);
+    }
+  }
+
+  /*
+   * A slot can go back to empty when its group still has an empty slot, since no probe sequence
+   * can have passed through a group that was never full. Otherwise it becomes a tombstone.
+   */
+  void erase_at(usize idx) noexcept {
+    slot_traits::destroy(alloc, slots + idx);
+    element_count--;
+
+    const auto base{idx - idx % detail::group_size};
+    if (detail::group{ctrl + base}.match_empty().any()) {
+      ctrl[idx] = detail::ctrl_empty;
+      growth_left++;
+    } else {
+      ctrl[idx] = detail::ctrl_deleted;
+    }
+  }
+
+  template <typename K> auto erase_key(const K &key) noexcept -> usize {
+    const auto idx{find_index(key)};
+    if (idx == slot_count) {
+      return 0;
+    }
+    erase_at(idx);
+    return 1;
+  }
+
+  template <typename K> auto at_impl(const K &key) -> Value & {
+    const auto idx{find_index(key)};
+    if (idx == slot_count) {
+      throw std::out_of_range{"surge::containers::flat_hash_map::at: key not found"};
+    }
+    return slots[idx].second;
+  }
+
+  template <typename K, typename V> void insert_unique(K &&key, V &&value) {
+    const auto idx{prepare_insert(hash_of(key))};
+    slot_traits::construct(alloc, slots + idx, std::piecewise_construct,
+                           std::forward_as_tuple(std::forward<K>(key)),
+                           std::forward_as_tuple(std::forward<V>(value)));
+  }
+
+  void release() noexcept {
+    if (slot_count == 0) {
+      return;
+    }
+
+    clear();
+
+    ctrl_allocator c_alloc{alloc};
+    ctrl_traits::deallocate(c_alloc, ctrl, slot_count);
+    slot_traits::deallocate(alloc, slots, slot_count);
+
+    ctrl = nullptr;
+    slots = nullptr;
+    slot_count = 0;
+    growth_left = 0;
+  }
+};
+
+} // namespace surge::containers
+
+#endif // SURGE_CORE_FLAT_HASH_MAP_HPP
\ No newline at end of file
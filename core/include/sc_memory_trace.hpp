@@ -0,0 +1,55 @@
+#ifndef SURGE_CORE_MEMORY_TRACE_HPP
+#define SURGE_CORE_MEMORY_TRACE_HPP
+
+#include "sc_allocators.hpp"
+#include "sc_error_types.hpp"
+#include "sc_integer_types.hpp"
+
+#include <optional>
+
+/*
+ * Binary memory event recorder. Allocator events are written as fixed-size records into a
+ * lock-free ring buffer and periodically drained into a trace file, which can be inspected offline
+ * with the surge_memtrace tool. The allocators only record events when SURGE_DEBUG_MEMORY is on.
+ */
+namespace surge::allocators::trace {
+
+enum class op : u8 {
+  alloc,          // Heap allocation of size bytes at address
+  free,           // Heap free of the allocation at address
+  arena_alloc,    // Allocation of size bytes at address inside an arena
+  arena_reset,    // The arena at address was reset
+  internal_alloc, // Driver internal allocation of size bytes
+  internal_free,  // Driver internal free of size bytes
+  dropped         // size events were lost because the ring buffer overflowed
+};
+
+struct record {
+  u64 timestamp{0}; // Nanoseconds since the trace was started
+  u64 address{0};
+  u64 size{0};
+  u32 thread{0};
+  op operation{op::alloc};
+  accounting::tag tag{accounting::tag::general};
+  u16 reserved{0};
+};
+
+static_assert(sizeof(record) == 32, "Memory trace records must be 32 bytes long");
+
+// A trace file is a file_header followed by records until the end of the file
+struct file_header {
+  char magic[4]{'S', 'M', 'T', 'R'};
+  u32 version{1};
+  u32 record_size{sizeof(record)};
+  u32 reserved{0};
+};
+
+auto start(const char *path) noexcept -> std::optional<error>;
+void flush() noexcept;
+void stop() noexcept;
+
+void record_event(op operation, accounting::tag t, const void *address, usize size) noexcept;
+
+} // namespace surge::allocators::trace
+
+#endif // SURGE_CORE_MEMORY_TRACE_HPP
\ No newline at end of file
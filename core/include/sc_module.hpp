@@ -1,10 +1,12 @@
 #ifndef SURGE_CORE_MODULE_HPP
 #define SURGE_CORE_MODULE_HPP
 
+#include "sc_allocators.hpp"
 #include "sc_container_types.hpp"
 #include "sc_error_types.hpp"
 #include "sc_glfw_includes.hpp"
 #include "sc_options.hpp"
+#include "sc_tasks.hpp"
 #include "sc_vulkan/sc_vulkan.hpp"
 
 // clang-format off
@@ -16,6 +18,7 @@
 #endif
 // clang-format on
 
+#include <atomic>
 #include <optional>
 #include <tl/expected.hpp>
 
@@ -27,6 +30,18 @@ using handle_t = HMODULE;
 using handle_t = void *;
 #endif
 
+/*
+ * State shared between the player and the tasks of a module's update graph. The player refreshes
+ * it before running the graph each frame. Any task may set status to a non zero value to close
+ * the player, the same as returning non zero from update. Tasks run on executor workers, so
+ * graphics API calls belong in draw.
+ */
+struct update_frame {
+  window::window_t window{nullptr};
+  double dt{0.0};
+  std::atomic<int> status{0};
+};
+
 struct gl_api {
   using on_load_t = int (*)(surge::window::window_t);
   using on_unload_t = int (*)(surge::window::window_t);
@@ -37,6 +52,9 @@ struct gl_api {
   using mouse_button_event_t = void (*)(surge::window::window_t, int, int, int);
   using mouse_scroll_event_t = void (*)(surge::window::window_t, double, double);
 
+  // Optional. Fills the taskflow with the update stages of the module, see build_update_graph
+  using build_update_graph_t = int (*)(tf::Taskflow &, update_frame &);
+
   on_load_t on_load;
   on_unload_t on_unload;
 
@@ -46,6 +64,8 @@ struct gl_api {
   keyboard_event_t keyboard_event;
   mouse_button_event_t mouse_button_event;
   mouse_scroll_event_t mouse_scroll_event;
+
+  build_update_graph_t build_update_graph;
 };
 
 struct vk_api {
@@ -58,6 +78,10 @@ struct vk_api {
   using mouse_button_event_t = void (*)(surge::window::window_t, int, int, int);
   using mouse_scroll_event_t = void (*)(surge::window::window_t, double, double);
 
+  // Optional. Fills the taskflow with the update stages of the module, see build_update_graph
+  using build_update_graph_t
+      = int (*)(tf::Taskflow &, update_frame &, surge::renderer::vk::context);
+
   on_load_t on_load;
   on_unload_t on_unload;
 
@@ -67,23 +91,55 @@ struct vk_api {
   keyboard_event_t keyboard_event;
   mouse_button_event_t mouse_button_event;
   mouse_scroll_event_t mouse_scroll_event;
+
+  build_update_graph_t build_update_graph;
 };
 
 auto get_name(handle_t module, usize max_size = 256) noexcept -> tl::expected<string, error>;
 
+// Missing symbols are logged unless required is false
 #ifdef SURGE_SYSTEM_Windows
-auto get_func_addr(surge::module::handle_t module, const char *func_name) -> std::optional<FARPROC>;
+auto get_func_addr(surge::module::handle_t module, const char *func_name, bool required = true)
+    -> std::optional<FARPROC>;
 #else
-auto get_func_addr(surge::module::handle_t module, const char *func_name) -> std::optional<void *>;
+auto get_func_addr(surge::module::handle_t module, const char *func_name, bool required = true)
+    -> std::optional<void *>;
 #endif
 
 auto load(const char *path) noexcept -> tl::expected<handle_t, error>;
 void unload(handle_t module) noexcept;
 auto reload(handle_t module) noexcept -> tl::expected<handle_t, error>;
 
+/*
+ * Each loaded module owns a heap, which should be made the default heap around calls into the
+ * module API using allocators::mimalloc::heap_scope. Unloading the module destroys the heap and
+ * everything the module left allocated in it. Engine objects a module creates or grows from these
+ * calls, like texture and text databases, glyph caches and ecs::registry storage, live in the heap
+ * too, so the module must destroy them in on_unload and cannot hand them over to the reloaded
+ * module. Engine state that outlives modules, such as pools, frame arenas and sprite databases, is
+ * pinned to the backing heap instead. Memory still held by the heap at unload is reported as an
+ * error, since pointers to it would dangle.
+ */
+auto get_heap(handle_t module) noexcept -> allocators::mimalloc::heap_t *;
+auto get_heap_usage(handle_t module) noexcept -> usize;
+
 auto get_gl_api(handle_t module) noexcept -> tl::expected<gl_api, error>;
 auto get_vk_api(handle_t module) noexcept -> tl::expected<vk_api, error>;
 
+/*
+ * Rebuilds the update graph of a module. Modules that export {gl,vk}_build_update_graph describe
+ * their update as a taskflow, built once here and then run by the player on the executor every
+ * frame in place of update, joining before draw. The graph is left empty for modules without one.
+ * It must be cleared before the module is unloaded, since its tasks run module code. Tasks run on
+ * executor workers, outside the module heap, since a mimalloc heap only serves the thread that
+ * created it. Memory they allocate comes from the worker's backing heap and is not released with
+ * the module, so tasks should leave allocation to on_load or use frame scope memory.
+ */
+auto build_update_graph(const gl_api &api, tf::Taskflow &graph, update_frame &frame) noexcept
+    -> std::optional<error>;
+auto build_update_graph(const vk_api &api, tf::Taskflow &graph, update_frame &frame,
+                        renderer::vk::context ctx) noexcept -> std::optional<error>;
+
 auto set_module_path() noexcept -> bool;
 
 void bind_input_callbacks(surge::window::window_t window, handle_t handle, const gl_api &api);
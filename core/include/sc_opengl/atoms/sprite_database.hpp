@@ -1,6 +1,7 @@
 #ifndef SURGE_CORE_GL_ATOM_SPRITE_DATABASE_HPP
 #define SURGE_CORE_GL_ATOM_SPRITE_DATABASE_HPP
 
+#include "sc_allocators.hpp"
 #include "sc_error_types.hpp"
 #include "sc_integer_types.hpp"
 #include "sc_opengl/sc_opengl.hpp"
@@ -16,8 +17,13 @@ struct database_create_info {
   usize buffer_redundancy{3}; // The number of buffers to cycle trough
 };
 
+/*
+ * Databases are referred to by pool handles, which every call validates before touching the
+ * database, so a handle kept past destroy(), like one held by a module across a hot reload, is
+ * rejected instead of reaching freed or reused memory.
+ */
 struct database_t;
-using database = database_t *;
+using database = allocators::pool_handle<database_t>;
 
 auto create(database_create_info ci) noexcept -> tl::expected<database, error>;
 void destroy(database sdb) noexcept;
@@ -42,6 +48,24 @@ void add_view(database sdb, GLuint64 handle, const glm::vec2 &pos, const glm::ve
               glm::vec4 image_view, glm::vec2 img_dims,
               const glm::vec4 &color_mod = glm::vec4{1.0f}) noexcept;
 
+/*
+ * Slots reserved in the current write buffer. Each slot can then be filled with write() from any
+ * thread, as long as no two threads write the same slot.
+ */
+struct slot_range {
+  usize first{0};
+  usize count{0};
+};
+
+auto reserve(database sdb, usize count) noexcept -> slot_range;
+
+void write(database sdb, usize slot, GLuint64 texture_handle, const glm::mat4 &model_matrix,
+           const glm::vec4 &color_mod = glm::vec4{1.0f},
+           const glm::vec4 &view = glm::vec4{1.0f, 1.0f, 0.0f, 0.0f}) noexcept;
+
+// Converts a pixel region {u0, v0, w, h} of an image with the given dimensions to a sprite view
+auto make_view(const glm::vec4 &image_view, const glm::vec2 &img_dims) noexcept -> glm::vec4;
+
 void add_depth(database sdb, GLuint64 texture, GLuint64 depth_map, glm::mat4 model) noexcept;
 
 void draw(database sdb) noexcept;
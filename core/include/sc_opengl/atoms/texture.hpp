@@ -8,6 +8,8 @@
 #include "sc_opengl/sc_opengl.hpp"
 #include "sc_options.hpp"
 
+#include <chrono>
+#include <future>
 #include <optional>
 #include <xxhash.h>
 
@@ -81,11 +83,8 @@ public:
       i++;
     }
 
-    tasks::executor::get().wait_for_all();
-
     // Handle image load errors and push image data to record.
-    for (auto &f : img_futures) {
-      auto img{f.get()};
+    const auto upload{[&](files::image img) {
       if (img) {
         const auto texture_data{from_image(ci, *img)};
         if (texture_data) {
@@ -97,6 +96,32 @@ public:
         }
         files::free_image_task(*img);
       }
+    }};
+
+    /*
+     * Upload each image as soon as its decode completes, so a slow file does not hold back the
+     * others. Only the futures of this batch are waited on. When none is ready, wait on one for a
+     * short slice before polling them all again, rather than spinning or blocking behind it.
+     */
+    for (usize pending = num_paths; pending > 0;) {
+      files::img_future *waiting{nullptr};
+
+      for (auto &f : img_futures) {
+        if (!f.valid()) {
+          continue;
+        }
+
+        if (f.wait_for(std::chrono::seconds{0}) == std::future_status::ready) {
+          upload(f.get());
+          pending--;
+        } else if (waiting == nullptr) {
+          waiting = &f;
+        }
+      }
+
+      if (pending > 0 && waiting != nullptr) {
+        waiting->wait_for(std::chrono::milliseconds{1});
+      }
     }
   }
 
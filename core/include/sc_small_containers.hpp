@@ -0,0 +1,394 @@
+#ifndef SURGE_CORE_SMALL_CONTAINERS_HPP
+#define SURGE_CORE_SMALL_CONTAINERS_HPP
+
+#include "sc_integer_types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace surge::containers {
+
+/*
+ * Vector that stores up to N elements inside the object and only moves them to the heap once it
+ * outgrows that space. Meant for the many short lists built while setting up Vulkan objects or
+ * during a frame, which would otherwise cost one heap allocation each.
+ *
+ * Iterators are plain pointers and, like with std::vector, growing invalidates them. Moving a
+ * small_vector that still uses its inline storage moves the elements one by one.
+ */
+template <typename T, usize N, typename Allocator = std::allocator<T>> class small_vector {
+  static_assert(N > 0, "small_vector needs room for at least one inline element");
+
+public:
+  using value_type = T;
+  using size_type = usize;
+  using difference_type = std::ptrdiff_t;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using iterator = T *;
+  using const_iterator = const T *;
+  using allocator_type = Allocator;
+
+private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+
+  T *elements{inline_data()};
+  usize count{0};
+  usize cap{N};
+
+  [[no_unique_address]] Allocator alloc{};
+  alignas(T) std::byte inline_storage[N * sizeof(T)];
+
+  [[nodiscard]] auto inline_data() noexcept -> T * {
+    return std::launder(reinterpret_cast<T *>(inline_storage));
+  }
+
+public:
+  small_vector() noexcept {}
+
+  explicit small_vector(const Allocator &a) noexcept : alloc{a} {}
+
+  explicit small_vector(usize n) : small_vector() { resize(n); }
+
+  small_vector(usize n, const T &value) : small_vector() { resize(n, value); }
+
+  template <std::input_iterator It> small_vector(It first, It last) : small_vector() {
+    if constexpr (std::forward_iterator<It>) {
+      reserve(static_cast<usize>(std::distance(first, last)));
+    }
+    for (; first != last; ++first) {
+      emplace_back(*first);
+    }
+  }
+
+  small_vector(std::initializer_list<T> values) : small_vector(values.begin(), values.end()) {}
+
+  small_vector(const small_vector &other)
+      : alloc{alloc_traits::select_on_container_copy_construction(other.alloc)} {
+    reserve(other.count);
+    std::uninitialized_copy(other.begin(), other.end(), elements);
+    count = other.count;
+  }
+
+  small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+      : alloc{std::move(other.alloc)} {
+    take(std::move(other));
+  }
+
+  auto operator=(const small_vector &other) -> small_vector & {
+    if (this != &other) {
+      clear();
+      reserve(other.count);
+      std::uninitialized_copy(other.begin(), other.end(), elements);
+      count = other.count;
+    }
+    return *this;
+  }
+
+  auto operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+      -> small_vector & {
+    if (this != &other) {
+      release();
+      alloc = std::move(other.alloc);
+      take(std::move(other));
+    }
+    return *this;
+  }
+
+  auto operator=(std::initializer_list<T> values) -> small_vector & {
+    clear();
+    reserve(values.size());
+    std::uninitialized_copy(values.begin(), values.end(), elements);
+    count = values.size();
+    return *this;
+  }
+
+  ~small_vector() noexcept { release(); }
+
+  /*
+   * Element access
+   */
+  [[nodiscard]] auto data() noexcept -> T * { return elements; }
+  [[nodiscard]] auto data() const noexcept -> const T * { return elements; }
+
+  [[nodiscard]] auto operator[](usize i) noexcept -> T & { return elements[i]; }
+  [[nodiscard]] auto operator[](usize i) const noexcept -> const T & { return elements[i]; }
+
+  [[nodiscard]] auto front() noexcept -> T & { return elements[0]; }
+  [[nodiscard]] auto front() const noexcept -> const T & { return elements[0]; }
+  [[nodiscard]] auto back() noexcept -> T & { return elements[count - 1]; }
+  [[nodiscard]] auto back() const noexcept -> const T & { return elements[count - 1]; }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return elements; }
+  [[nodiscard]] auto end() noexcept -> iterator { return elements + count; }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return elements; }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return elements + count; }
+  [[nodiscard]] auto cbegin() const noexcept -> const_iterator { return elements; }
+  [[nodiscard]] auto cend() const noexcept -> const_iterator { return elements + count; }
+
+  /*
+   * Capacity
+   */
+  [[nodiscard]] auto size() const noexcept -> usize { return count; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return count == 0; }
+  [[nodiscard]] auto capacity() const noexcept -> usize { return cap; }
+  [[nodiscard]] static constexpr auto inline_capacity() noexcept -> usize { return N; }
+
+  // True while the elements still live inside the object
+  [[nodiscard]] auto is_inline() const noexcept -> bool {
+    return elements == reinterpret_cast<const T *>(inline_storage);
+  }
+
+  void reserve(usize new_cap) {
+    if (new_cap <= cap) {
+      return;
+    }
+
+    auto new_elements{alloc_traits::allocate(alloc, new_cap)};
+    std::uninitialized_move(elements, elements + count, new_elements);
+    std::destroy(elements, elements + count);
+
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc, elements, cap);
+    }
+
+    elements = new_elements;
+    cap = new_cap;
+  }
+
+  /*
+   * Modifiers
+   */
+  template <typename... Args> auto emplace_back(Args &&...args) -> T & {
+    if (count == cap) {
+      grow_and_emplace(std::forward<Args>(args)...);
+    } else {
+      alloc_traits::construct(alloc, elements + count, std::forward<Args>(args)...);
+    }
+    return elements[count++];
+  }
+
+  void push_back(const T &value) { emplace_back(value); }
+  void push_back(T &&value) { emplace_back(std::move(value)); }
+
+  void pop_back() noexcept {
+    count--;
+    std::destroy_at(elements + count);
+  }
+
+  // Keeps the order of the remaining elements
+  auto erase(const_iterator pos) -> iterator {
+    const auto idx{static_cast<usize>(pos - elements)};
+    std::move(elements + idx + 1, elements + count, elements + idx);
+    pop_back();
+    return elements + idx;
+  }
+
+  void resize(usize n) {
+    reserve(n);
+    while (count < n) {
+      alloc_traits::construct(alloc, elements + count);
+      count++;
+    }
+    while (count > n) {
+      pop_back();
+    }
+  }
+
+  void resize(usize n, const T &value) {
+    reserve(n);
+    while (count < n) {
+      alloc_traits::construct(alloc, elements + count, value);
+      count++;
+    }
+    while (count > n) {
+      pop_back();
+    }
+  }
+
+  void clear() noexcept {
+    std::destroy(elements, elements + count);
+    count = 0;
+  }
+
+private:
+  // The new element is built before the old ones move, so args may refer to one of them
+  template <typename... Args> void grow_and_emplace(Args &&...args) {
+    const auto new_cap{cap * 2};
+    auto new_elements{alloc_traits::allocate(alloc, new_cap)};
+
+    try {
+      alloc_traits::construct(alloc, new_elements + count, std::forward<Args>(args)...);
+    } catch (...) {
+      alloc_traits::deallocate(alloc, new_elements, new_cap);
+      throw;
+    }
+
+    std::uninitialized_move(elements, elements + count, new_elements);
+    std::destroy(elements, elements + count);
+
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc, elements, cap);
+    }
+
+    elements = new_elements;
+    cap = new_cap;
+  }
+
+  // Heap buffers are stolen, inline elements are moved over
+  void take(small_vector &&other) {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), elements);
+      count = other.count;
+      other.clear();
+    } else {
+      elements = std::exchange(other.elements, other.inline_data());
+      count = std::exchange(other.count, 0);
+      cap = std::exchange(other.cap, N);
+    }
+  }
+
+  void release() noexcept {
+    clear();
+    if (!is_inline()) {
+      alloc_traits::deallocate(alloc, elements, cap);
+      elements = inline_data();
+      cap = N;
+    }
+  }
+};
+
+template <typename T, usize N, typename A>
+auto operator==(const small_vector<T, N, A> &a, const small_vector<T, N, A> &b) -> bool {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+/*
+ * Null terminated string with room for N characters inside the object, spilling to the heap when
+ * longer. c_str() is always valid, so it can be handed straight to C APIs. Moved from strings
+ * are empty, and stay null terminated.
+ */
+template <usize N, typename Allocator = std::allocator<char>> class basic_inline_string {
+private:
+  small_vector<char, N + 1, Allocator> chars{};
+
+public:
+  using value_type = char;
+  using size_type = usize;
+  using iterator = char *;
+  using const_iterator = const char *;
+
+  basic_inline_string() { chars.push_back('\0'); }
+
+  basic_inline_string(std::string_view s) { assign(s); }
+  basic_inline_string(const char *s) { assign(std::string_view{s}); }
+  basic_inline_string(const char *s, usize n) { assign(std::string_view{s, n}); }
+
+  basic_inline_string(const basic_inline_string &) = default;
+  auto operator=(const basic_inline_string &) -> basic_inline_string & = default;
+
+  // Moving empties the source vector, so the terminator is put back. It fits inline, no allocation
+  basic_inline_string(basic_inline_string &&other) noexcept : chars{std::move(other.chars)} {
+    other.chars.push_back('\0');
+  }
+
+  auto operator=(basic_inline_string &&other) noexcept -> basic_inline_string & {
+    if (this != &other) {
+      chars = std::move(other.chars);
+      other.chars.push_back('\0');
+    }
+    return *this;
+  }
+
+  auto operator=(std::string_view s) -> basic_inline_string & {
+    assign(s);
+    return *this;
+  }
+
+  auto operator=(const char *s) -> basic_inline_string & {
+    assign(std::string_view{s});
+    return *this;
+  }
+
+  void assign(std::string_view s) {
+    chars.clear();
+    chars.reserve(s.size() + 1);
+    for (const auto c : s) {
+      chars.push_back(c);
+    }
+    chars.push_back('\0');
+  }
+
+  [[nodiscard]] auto c_str() const noexcept -> const char * { return chars.data(); }
+  [[nodiscard]] auto data() noexcept -> char * { return chars.data(); }
+  [[nodiscard]] auto data() const noexcept -> const char * { return chars.data(); }
+
+  [[nodiscard]] auto size() const noexcept -> usize { return chars.size() - 1; }
+  [[nodiscard]] auto length() const noexcept -> usize { return size(); }
+  [[nodiscard]] auto empty() const noexcept -> bool { return size() == 0; }
+  [[nodiscard]] auto capacity() const noexcept -> usize { return chars.capacity() - 1; }
+  [[nodiscard]] auto is_inline() const noexcept -> bool { return chars.is_inline(); }
+
+  [[nodiscard]] auto operator[](usize i) noexcept -> char & { return chars[i]; }
+  [[nodiscard]] auto operator[](usize i) const noexcept -> char { return chars[i]; }
+
+  [[nodiscard]] auto begin() noexcept -> iterator { return chars.begin(); }
+  [[nodiscard]] auto end() noexcept -> iterator { return chars.begin() + size(); }
+  [[nodiscard]] auto begin() const noexcept -> const_iterator { return chars.begin(); }
+  [[nodiscard]] auto end() const noexcept -> const_iterator { return chars.begin() + size(); }
+
+  [[nodiscard]] auto view() const noexcept -> std::string_view { return {chars.data(), size()}; }
+  operator std::string_view() const noexcept { return view(); }
+
+  void reserve(usize n) { chars.reserve(n + 1); }
+
+  void clear() noexcept {
+    chars.clear();
+    chars.push_back('\0');
+  }
+
+  void push_back(char c) {
+    chars.back() = c;
+    chars.push_back('\0');
+  }
+
+  auto append(std::string_view s) -> basic_inline_string & {
+    chars.reserve(chars.size() + s.size());
+    chars.pop_back();
+    for (const auto c : s) {
+      chars.push_back(c);
+    }
+    chars.push_back('\0');
+    return *this;
+  }
+
+  auto operator+=(std::string_view s) -> basic_inline_string & { return append(s); }
+
+  auto operator+=(char c) -> basic_inline_string & {
+    push_back(c);
+    return *this;
+  }
+
+  friend auto operator==(const basic_inline_string &a, std::string_view b) noexcept -> bool {
+    return a.view() == b;
+  }
+
+  // Lets fmt print inline strings directly
+  friend auto format_as(const basic_inline_string &s) noexcept -> std::string_view {
+    return s.view();
+  }
+};
+
+} // namespace surge::containers
+
+#endif // SURGE_CORE_SMALL_CONTAINERS_HPP
\ No newline at end of file
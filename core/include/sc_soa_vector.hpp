@@ -0,0 +1,273 @@
+#ifndef SURGE_CORE_SOA_VECTOR_HPP
+#define SURGE_CORE_SOA_VECTOR_HPP
+
+#include "sc_allocators.hpp"
+#include "sc_integer_types.hpp"
+
+#include <cstring>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace surge::containers {
+
+/*
+ * Structure of arrays container. Each field type gets its own contiguous column, and row i of the
+ * container is made of element i of every column. Passes that only need a few fields (culling on
+ * positions, sorting on depth keys) stream just those columns instead of whole structs.
+ *
+ * All columns live in a single block, each starting on a cache line boundary. Fields must be
+ * trivially copyable and destructible, since columns are grown and reordered with memcpy. Growing
+ * invalidates every span and reference into the columns.
+ */
+template <typename... Fields> class soa_vector {
+  static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+  static_assert((std::is_trivially_copyable_v<Fields> && ...),
+                "soa_vector fields must be trivially copyable");
+  static_assert((std::is_trivially_destructible_v<Fields> && ...),
+                "soa_vector fields must be trivially destructible");
+
+public:
+  static constexpr usize field_count{sizeof...(Fields)};
+  static constexpr usize column_alignment{allocators::cache_line_size};
+
+  template <usize I> using field_t = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+private:
+  std::byte *block{nullptr};
+  std::tuple<Fields *...> columns{};
+  usize count{0};
+  usize cap{0};
+
+  static constexpr auto align_up(usize v) noexcept -> usize {
+    return (v + column_alignment - 1) & ~(column_alignment - 1);
+  }
+
+  static constexpr auto block_size(usize capacity) noexcept -> usize {
+    return (align_up(capacity * sizeof(Fields)) + ...);
+  }
+
+  // Carves the columns out of a block, in field order
+  static auto make_columns(std::byte *b, usize capacity) noexcept -> std::tuple<Fields *...> {
+    usize offset{0};
+    const auto carve{[&]<typename T>(std::type_identity<T>) -> T * {
+      auto p{reinterpret_cast<T *>(b + offset)};
+      offset += align_up(capacity * sizeof(T));
+      return p;
+    }};
+    return std::tuple<Fields *...>{carve(std::type_identity<Fields>{})...};
+  }
+
+  template <usize... I> void copy_rows(std::tuple<Fields *...> &dst, usize dst_first,
+                                       const std::tuple<Fields *...> &src, usize src_first,
+                                       usize rows, std::index_sequence<I...>) noexcept {
+    if (rows == 0) {
+      return;
+    }
+    (std::memcpy(std::get<I>(dst) + dst_first, std::get<I>(src) + src_first,
+                 rows * sizeof(field_t<I>)),
+     ...);
+  }
+
+  void release() noexcept {
+    if (block != nullptr) {
+      allocators::mimalloc::aligned_free(block, column_alignment);
+    }
+    block = nullptr;
+    columns = {};
+    count = 0;
+    cap = 0;
+  }
+
+  void grow_for(usize needed) {
+    if (needed > cap) {
+      reserve(needed > cap * 2 ? needed : cap * 2);
+    }
+  }
+
+public:
+  soa_vector() noexcept = default;
+
+  explicit soa_vector(usize capacity) { reserve(capacity); }
+
+  soa_vector(const soa_vector &other) {
+    reserve(other.count);
+    copy_rows(columns, 0, other.columns, 0, other.count, std::index_sequence_for<Fields...>{});
+    count = other.count;
+  }
+
+  soa_vector(soa_vector &&other) noexcept
+      : block{std::exchange(other.block, nullptr)},
+        columns{std::exchange(other.columns, {})},
+        count{std::exchange(other.count, 0)},
+        cap{std::exchange(other.cap, 0)} {}
+
+  auto operator=(const soa_vector &other) -> soa_vector & {
+    if (this != &other) {
+      clear();
+      reserve(other.count);
+      copy_rows(columns, 0, other.columns, 0, other.count, std::index_sequence_for<Fields...>{});
+      count = other.count;
+    }
+    return *this;
+  }
+
+  auto operator=(soa_vector &&other) noexcept -> soa_vector & {
+    if (this != &other) {
+      release();
+      block = std::exchange(other.block, nullptr);
+      columns = std::exchange(other.columns, {});
+      count = std::exchange(other.count, 0);
+      cap = std::exchange(other.cap, 0);
+    }
+    return *this;
+  }
+
+  ~soa_vector() noexcept { release(); }
+
+  /*
+   * Capacity
+   */
+  [[nodiscard]] auto size() const noexcept -> usize { return count; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return count == 0; }
+  [[nodiscard]] auto capacity() const noexcept -> usize { return cap; }
+
+  void reserve(usize new_cap) {
+    if (new_cap <= cap) {
+      return;
+    }
+
+    auto new_block{static_cast<std::byte *>(
+        allocators::mimalloc::aligned_alloc(block_size(new_cap), column_alignment))};
+    if (new_block == nullptr) {
+      throw std::bad_alloc();
+    }
+
+    auto new_columns{make_columns(new_block, new_cap)};
+    copy_rows(new_columns, 0, columns, 0, count, std::index_sequence_for<Fields...>{});
+
+    const auto old_count{count};
+    release();
+
+    block = new_block;
+    columns = new_columns;
+    count = old_count;
+    cap = new_cap;
+  }
+
+  // New rows are value initialized
+  void resize(usize n) {
+    reserve(n);
+    for (auto i = count; i < n; i++) {
+      std::apply([&](Fields *...cols) { ((cols[i] = Fields{}), ...); }, columns);
+    }
+    count = n;
+  }
+
+  void clear() noexcept { count = 0; }
+
+  /*
+   * Columns
+   */
+  template <usize I> [[nodiscard]] auto column() noexcept -> std::span<field_t<I>> {
+    return {std::get<I>(columns), count};
+  }
+
+  template <usize I> [[nodiscard]] auto column() const noexcept -> std::span<const field_t<I>> {
+    return {std::get<I>(columns), count};
+  }
+
+  // By type, for field types that appear only once
+  template <typename T> [[nodiscard]] auto column() noexcept -> std::span<T> {
+    return {std::get<T *>(columns), count};
+  }
+
+  template <typename T> [[nodiscard]] auto column() const noexcept -> std::span<const T> {
+    return {std::get<T *>(columns), count};
+  }
+
+  /*
+   * Rows
+   */
+  template <usize I> [[nodiscard]] auto get(usize row) noexcept -> field_t<I> & {
+    return std::get<I>(columns)[row];
+  }
+
+  template <usize I> [[nodiscard]] auto get(usize row) const noexcept -> const field_t<I> & {
+    return std::get<I>(columns)[row];
+  }
+
+  [[nodiscard]] auto row(usize i) noexcept -> std::tuple<Fields &...> {
+    return std::apply([&](Fields *...cols) { return std::tuple<Fields &...>{cols[i]...}; },
+                      columns);
+  }
+
+  // Returns the index of the new row
+  auto push_back(const Fields &...values) -> usize {
+    // Copied first, values may point into the columns about to be reallocated
+    const std::tuple<Fields...> new_row{values...};
+    grow_for(count + 1);
+    [&]<usize... I>(std::index_sequence<I...>) {
+      ((std::get<I>(columns)[count] = std::get<I>(new_row)), ...);
+    }(std::index_sequence_for<Fields...>{});
+    return count++;
+  }
+
+  /*
+   * Appends one row per element of the given spans, one span per field. All spans must have the
+   * same length, otherwise nothing is appended. Returns the index of the first appended row.
+   */
+  auto append(std::span<const Fields>... values) -> usize {
+    const usize rows{std::get<0>(std::forward_as_tuple(values...)).size()};
+    if (rows == 0 || ((values.size() != rows) || ...)) {
+      return count;
+    }
+
+    grow_for(count + rows);
+
+    const auto first{count};
+    copy_rows(columns, first, std::tuple<Fields *...>{const_cast<Fields *>(values.data())...}, 0,
+              rows, std::index_sequence_for<Fields...>{});
+
+    count += rows;
+    return first;
+  }
+
+  // O(1) removal that moves the last row into the removed one. Row order is not kept
+  void swap_remove(usize i) noexcept {
+    count--;
+    if (i != count) {
+      std::apply([&](Fields *...cols) { ((cols[i] = cols[count]), ...); }, columns);
+    }
+  }
+
+  void pop_back() noexcept { count--; }
+
+  /*
+   * Reorders all columns so that row k becomes the old row order[k]. order must be a permutation
+   * of [0, size()). Typically used after sorting an index array on one key column.
+   */
+  template <typename Index> void gather(std::span<const Index> order) {
+    soa_vector reordered{count};
+    std::apply(
+        [&](Fields *...dst) {
+          std::apply(
+              [&](Fields *...src) {
+                for (usize k = 0; k < count; k++) {
+                  const auto from{static_cast<usize>(order[k])};
+                  ((dst[k] = src[from]), ...);
+                }
+              },
+              columns);
+        },
+        reordered.columns);
+    reordered.count = count;
+    *this = std::move(reordered);
+  }
+};
+
+} // namespace surge::containers
+
+#endif // SURGE_CORE_SOA_VECTOR_HPP
\ No newline at end of file
@@ -1,22 +1,229 @@
 #ifndef SURGE_CORE_TASKS_HPP
 #define SURGE_CORE_TASKS_HPP
 
+#include "sc_allocators.hpp"
+#include "sc_config.hpp"
+#include "sc_container_types.hpp"
+#include "sc_integer_types.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <taskflow/algorithm/for_each.hpp>
+#include <taskflow/algorithm/sort.hpp>
 #include <taskflow/taskflow.hpp>
 
 namespace surge::tasks {
 
+/*
+ * Jobs are split in priority classes, each with its own executor and worker threads, so work
+ * stealing happens inside a class and a burst of one class cannot fill the queues of another.
+ * - frame_critical: work the current frame waits on, like update graphs and parallel loops.
+ * - normal: asynchronous work needed soon, but not by this frame.
+ * - background: streaming work, like decoding and freeing assets. Runs on low priority threads
+ *   and yields when the frame deadline approaches, see yield_to_frame().
+ */
+enum class priority { frame_critical, normal, background };
+
 class executor {
 private:
   executor() = default;
   ~executor() = default;
 
 public:
+  /**
+   * @brief Sets the worker count, affinity and priority of the executor and pins the calling
+   * thread to the reserved main thread core, if any. Must be called from the main thread before the
+   * first call to get(), otherwise the defaults (one worker per core but one) are kept.
+   */
+  static void configure(const config::executor_attrs &attrs);
+
+  // The frame critical executor
   static auto get() -> tf::Executor &;
+  static auto get(priority p) -> tf::Executor &;
 
   executor(const executor &) = delete;
   executor &operator=(const executor &) = delete;
 };
 
+/**
+ * @brief Marks the start of a frame that should complete within budget seconds. Called by the
+ * player once per frame, before the module update.
+ */
+void begin_frame(double budget) noexcept;
+
+/**
+ * @brief Marks the end of the critical part of a frame, once it has been presented, and resumes
+ * the background jobs that yielded to it.
+ */
+void end_frame() noexcept;
+
+/**
+ * @brief Pauses the calling background worker while the running frame is close to its deadline.
+ *
+ * Returns immediately outside background workers, outside a frame or while the deadline is still
+ * far. The pause ends when the frame ends or the deadline passes, so a frame that waits on a
+ * background job is delayed at most by the configured yield time. Background jobs submitted with
+ * async() call it before starting, and long jobs should call it between chunks of work.
+ */
+void yield_to_frame() noexcept;
+
+/**
+ * @brief Runs fn on the executor of class p. Returns a future to its result.
+ */
+template <typename F> auto async(priority p, F &&fn) {
+  if (p == priority::background) {
+    return executor::get(p).async([fn = std::forward<F>(fn)]() mutable {
+      yield_to_frame();
+      return fn();
+    });
+  }
+  return executor::get(p).async(std::forward<F>(fn));
+}
+
+/**
+ * @brief Same as async(), without a future.
+ */
+template <typename F> void silent_async(priority p, F &&fn) {
+  if (p == priority::background) {
+    executor::get(p).silent_async([fn = std::forward<F>(fn)]() mutable {
+      yield_to_frame();
+      fn();
+    });
+    return;
+  }
+  executor::get(p).silent_async(std::forward<F>(fn));
+}
+
+/**
+ * @brief Runs a taskflow on the executor and blocks until it completes.
+ *
+ * Called from an executor worker, the flow runs on the executor of that worker's priority class and
+ * the worker keeps running other tasks while it waits, so nested parallel work cannot starve the
+ * pool. Called from any other thread, it runs on the frame critical executor.
+ */
+void run_and_wait(tf::Taskflow &flow);
+
+/**
+ * @brief Picks a grain size for a loop of count iterations. The range is split in a few chunks per
+ * worker of the executor run_and_wait() would use, so idle workers have something to steal, but
+ * chunks never get small enough for scheduling to cost more than the work.
+ */
+auto auto_grain(usize count) noexcept -> usize;
+
+// Sorts shorter than this are not worth splitting
+inline constexpr usize parallel_sort_cutoff{16384};
+
+/**
+ * @brief Calls fn(i) for every i in [first, last) on the executor, at least grain iterations per
+ * task. A grain of 0 picks one with auto_grain(). Ranges that fit in a single grain run serially
+ * on the calling thread.
+ */
+template <typename F> void parallel_for(usize first, usize last, usize grain, F &&fn) {
+  if (last <= first) {
+    return;
+  }
+
+  const auto count{last - first};
+  if (grain == 0) {
+    grain = auto_grain(count);
+  }
+
+  if (count <= grain) {
+    for (auto i = first; i < last; i++) {
+      fn(i);
+    }
+    return;
+  }
+
+  tf::Taskflow flow{};
+  flow.for_each_index(first, last, usize{1}, [&](usize i) { fn(i); },
+                      tf::GuidedPartitioner{grain});
+  run_and_wait(flow);
+}
+
+template <typename F> void parallel_for(usize first, usize last, F &&fn) {
+  parallel_for(first, last, 0, std::forward<F>(fn));
+}
+
+/**
+ * @brief Returns reduce(...reduce(init, map(first))..., map(last - 1)), with the maps and the
+ * partial reductions of each chunk running on the executor. reduce must be associative. Partial
+ * results are combined in chunk order, so the result does not depend on scheduling. A grain of 0
+ * picks one with auto_grain().
+ */
+template <typename T, typename Map, typename Reduce>
+auto parallel_reduce(usize first, usize last, usize grain, T init, Map &&map, Reduce &&reduce)
+    -> T {
+  if (last <= first) {
+    return init;
+  }
+
+  const auto count{last - first};
+  if (grain == 0) {
+    grain = auto_grain(count);
+  }
+
+  if (count <= grain) {
+    for (auto i = first; i < last; i++) {
+      init = reduce(std::move(init), map(i));
+    }
+    return init;
+  }
+
+  const auto chunks{(count + grain - 1) / grain};
+  vector<std::optional<T>> partials(chunks);
+
+  parallel_for(0, chunks, 1, [&](usize c) {
+    const auto chunk_first{first + c * grain};
+    const auto chunk_last{std::min(last, chunk_first + grain)};
+
+    T partial{map(chunk_first)};
+    for (auto i = chunk_first + 1; i < chunk_last; i++) {
+      partial = reduce(std::move(partial), map(i));
+    }
+    partials[c] = std::move(partial);
+  });
+
+  for (auto &p : partials) {
+    init = reduce(std::move(init), std::move(*p));
+  }
+  return init;
+}
+
+template <typename T, typename Map, typename Reduce>
+auto parallel_reduce(usize first, usize last, T init, Map &&map, Reduce &&reduce) -> T {
+  return parallel_reduce(first, last, 0, std::move(init), std::forward<Map>(map),
+                         std::forward<Reduce>(reduce));
+}
+
+/**
+ * @brief Sorts [first, last) with taskflow's parallel sort. Short ranges fall back to std::sort on
+ * the calling thread.
+ */
+template <std::random_access_iterator It, typename Compare = std::less<>>
+void parallel_sort(It first, It last, Compare comp = {}) {
+  if (static_cast<usize>(std::distance(first, last)) <= parallel_sort_cutoff) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  tf::Taskflow flow{};
+  flow.sort(first, last, comp);
+  run_and_wait(flow);
+}
+
+/**
+ * @brief Returns the scratch arena of the calling thread.
+ *
+ * The arena is created lazily on first use. When called from inside an executor task, the arena is
+ * reset as soon as the outermost task running on the worker completes, so memory obtained from it
+ * must not outlive the task. Threads outside the executor own their arena and must reset it
+ * themselves.
+ */
+auto scratch() -> allocators::mimalloc::arena &;
+
 } // namespace surge::tasks
 
 #endif // SURGE_CORE_TASKS_HPP
\ No newline at end of file
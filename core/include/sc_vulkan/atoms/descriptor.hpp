@@ -25,7 +25,7 @@ private:
   static constexpr u32 max_sets_per_pool{4096};
   u32 sets_per_pool{0};
 
-  vector<pool_size_ratio> ratios{};
+  small_vector<pool_size_ratio, 8> ratios{};
   vector<VkDescriptorPool> full_pools{};
   vector<VkDescriptorPool> ready_pools{};
 
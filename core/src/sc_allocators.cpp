@@ -2,117 +2,207 @@
 
 #include "sc_error_types.hpp"
 #include "sc_logging.hpp"
+#include "sc_memory_trace.hpp"
 #include "sc_options.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <cstring>
 #include <mimalloc.h>
+#include <new>
+#include <optional>
+#include <thread>
 #include <tl/expected.hpp>
+#include <vector>
 
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
 #  include <tracy/Tracy.hpp>
 #endif
 
-auto surge::allocators::mimalloc::malloc(usize size) -> void * {
+struct alignas(surge::allocators::cache_line_size) tag_counters {
+  std::atomic<surge::usize> current_bytes{0};
+  std::atomic<surge::usize> peak_bytes{0};
+  std::atomic<surge::usize> alloc_count{0};
+  std::atomic<surge::usize> free_count{0};
+};
+
+static std::array<tag_counters, surge::allocators::accounting::tag_count> tag_counters_table{};
+
+void surge::allocators::accounting::record_alloc(tag t, usize bytes) noexcept {
+  auto &c{tag_counters_table[static_cast<usize>(t)]};
+
+  const auto current{c.current_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes};
+  c.alloc_count.fetch_add(1, std::memory_order_relaxed);
+
+  auto peak{c.peak_bytes.load(std::memory_order_relaxed)};
+  while (current > peak
+         && !c.peak_bytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+  }
+}
+
+void surge::allocators::accounting::record_free(tag t, usize bytes) noexcept {
+  auto &c{tag_counters_table[static_cast<usize>(t)]};
+  c.current_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  c.free_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto surge::allocators::accounting::get(tag t) noexcept -> tag_stats {
+  const auto &c{tag_counters_table[static_cast<usize>(t)]};
+  return tag_stats{c.current_bytes.load(std::memory_order_relaxed),
+                   c.peak_bytes.load(std::memory_order_relaxed),
+                   c.alloc_count.load(std::memory_order_relaxed),
+                   c.free_count.load(std::memory_order_relaxed)};
+}
+
+auto surge::allocators::accounting::snapshot() noexcept -> snapshot_t {
+  snapshot_t s{};
+  for (usize i = 0; i < tag_count; i++) {
+    s[i] = get(static_cast<tag>(i));
+  }
+  return s;
+}
+
+auto surge::allocators::accounting::tag_name(tag t) noexcept -> const char * {
+  switch (t) {
+  case tag::general:
+    return "general";
+  case tag::textures:
+    return "textures";
+  case tag::fonts:
+    return "fonts";
+  case tag::vulkan:
+    return "vulkan";
+  case tag::config:
+    return "config";
+  default:
+    return "unknown";
+  }
+}
+
+auto surge::allocators::mimalloc::malloc(usize size, tag t) -> void * {
   auto p{mi_malloc(size)};
+  if (p != nullptr) {
+    accounting::record_alloc(t, mi_usable_size(p));
+  }
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: alloc\n"
-            "allocator: \"mimalloc::malloc\"\n"
-            "size: {}\n"
-            "address: {}\n"
-            "failed: {}",
-            size, p, p ? "false" : "true");
+  if (p != nullptr) {
+    trace::record_event(trace::op::alloc, t, p, size);
+  }
 #endif
   return p;
 }
 
-auto surge::allocators::mimalloc::realloc(void *p, usize newsize) -> void * {
+auto surge::allocators::mimalloc::realloc(void *p, usize newsize, tag t) -> void * {
+  const auto old_size{mi_usable_size(p)};
+
+#ifdef SURGE_DEBUG_MEMORY
+  // Recorded before p is released, so another thread reusing the address traces after it
+  if (p != nullptr) {
+    trace::record_event(trace::op::free, t, p, old_size);
+  }
+#endif
+
   auto q{mi_realloc(p, newsize)};
+  if (q != nullptr) {
+    if (p != nullptr) {
+      accounting::record_free(t, old_size);
+    }
+    accounting::record_alloc(t, mi_usable_size(q));
+  }
+
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: realloc\n"
-            "allocator: \"mimalloc::realloc\"\n"
-            "new size: {}\n"
-            "old address: {}\n"
-            "new address: {}\n"
-            "failed: {}",
-            newsize, p, q, q ? "false" : "true");
+  if (q != nullptr) {
+    trace::record_event(trace::op::alloc, t, q, newsize);
+  } else if (p != nullptr) {
+    // A failed realloc leaves p allocated
+    trace::record_event(trace::op::alloc, t, p, old_size);
+  }
 #endif
+
   return q;
 }
 
-auto surge::allocators::mimalloc::calloc(usize count, usize size) -> void * {
+auto surge::allocators::mimalloc::calloc(usize count, usize size, tag t) -> void * {
   auto p{mi_calloc(count, size)};
+  if (p != nullptr) {
+    accounting::record_alloc(t, mi_usable_size(p));
+  }
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: alloc\n"
-            "allocator: \"mimalloc::calloc\"\n"
-            "size: {}\n"
-            "count: {}\n"
-            "address: {}\n"
-            "failed: {}",
-            size, count, p, p ? "false" : "true");
+  if (p != nullptr) {
+    trace::record_event(trace::op::alloc, t, p, count * size);
+  }
 #endif
   return p;
 }
 
-void surge::allocators::mimalloc::free(void *p) {
+void surge::allocators::mimalloc::free(void *p, tag t) {
+  if (p != nullptr) {
+    accounting::record_free(t, mi_usable_size(p));
+  }
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: free\n"
-            "allocator: \"mimalloc::free\"\n"
-            "address: {}",
-            p);
+  if (p != nullptr) {
+    trace::record_event(trace::op::free, t, p, 0);
+  }
 #endif
   mi_free(p);
 }
 
-auto surge::allocators::mimalloc::aligned_alloc(usize size, usize alignment) -> void * {
+auto surge::allocators::mimalloc::aligned_alloc(usize size, usize alignment, tag t) -> void * {
   auto p{mi_aligned_alloc(alignment, size)};
+  if (p != nullptr) {
+    accounting::record_alloc(t, mi_usable_size(p));
+  }
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: alloc\n"
-            "allocator: \"mimalloc::mi_aligned_alloc\"\n"
-            "size: {}\n"
-            "alignment: {}\n"
-            "address: {}\n"
-            "failed: {}",
-            size, alignment, p, p ? "false" : "true");
+  if (p != nullptr) {
+    trace::record_event(trace::op::alloc, t, p, size);
+  }
 #endif
   return p;
 }
 
-auto surge::allocators::mimalloc::aligned_realloc(void *p, usize newsize, usize alignment)
+auto surge::allocators::mimalloc::aligned_realloc(void *p, usize newsize, usize alignment, tag t)
     -> void * {
+  const auto old_size{mi_usable_size(p)};
+
+#ifdef SURGE_DEBUG_MEMORY
+  // Recorded before p is released, so another thread reusing the address traces after it
+  if (p != nullptr) {
+    trace::record_event(trace::op::free, t, p, old_size);
+  }
+#endif
+
   auto q{mi_realloc_aligned(p, newsize, alignment)};
+  if (q != nullptr) {
+    if (p != nullptr) {
+      accounting::record_free(t, old_size);
+    }
+    accounting::record_alloc(t, mi_usable_size(q));
+  }
+
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: realloc\n"
-            "allocator: \"mimalloc::mi_realloc_aligned\"\n"
-            "new size: {}\n"
-            "alignent: {}\n",
-            "old address: {}\n"
-            "new address: {}\n"
-            "failed: {}",
-            newsize, alignment, p, q, q ? "false" : "true");
+  if (q != nullptr) {
+    trace::record_event(trace::op::alloc, t, q, newsize);
+  } else if (p != nullptr) {
+    // A failed realloc leaves p allocated
+    trace::record_event(trace::op::alloc, t, p, old_size);
+  }
 #endif
+
   return q;
 }
 
-void surge::allocators::mimalloc::aligned_free(void *p, usize alignment) {
+void surge::allocators::mimalloc::aligned_free(void *p, usize alignment, tag t) {
+  if (p != nullptr) {
+    accounting::record_free(t, mi_usable_size(p));
+  }
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: free\n"
-            "allocator: \"mimalloc::aligned_free\"\n"
-            "address: {}",
-            p);
+  if (p != nullptr) {
+    trace::record_event(trace::op::free, t, p, 0);
+  }
 #endif
   mi_free_aligned(p, alignment);
 }
@@ -130,21 +220,124 @@ void surge::allocators::mimalloc::init() {
 #endif
 
   mi_option_enable(mi_option_eager_commit);
-
-  mi_option_set(mi_option_reserve_huge_os_pages, 1);
   mi_option_set(mi_option_eager_commit_delay, 100);
 }
 
+// Heap that lives in the memory reserved for engine arenas. Owned by the main thread
+static mi_heap_t *arena_memory_heap{nullptr};
+
+auto surge::allocators::mimalloc::reserve_arena_memory(usize size, bool huge_pages)
+    -> std::optional<error> {
+  if (arena_memory_heap != nullptr) {
+    log_warn("Arena memory was already reserved");
+    return {};
+  }
+
+  log_info("Reserving {} B of arena memory{}", size, huge_pages ? " backed by huge pages" : "");
+
+  if (huge_pages) {
+    mi_option_enable(mi_option_large_os_pages);
+  }
+
+  mi_arena_id_t arena_id{};
+  if (mi_reserve_os_memory_ex(size, true, huge_pages, true, &arena_id) != 0) {
+    log_warn("Unable to reserve {} B of arena memory. Engine arenas will use the global heap",
+             size);
+    return error::arena_memory_reserve;
+  }
+
+  arena_memory_heap = mi_heap_new_in_arena(arena_id);
+
+  if (arena_memory_heap == nullptr) {
+    log_warn("Unable to create a heap in the arena memory. Engine arenas will use the global heap");
+    return error::arena_memory_reserve;
+  }
+
+  return {};
+}
+
+auto surge::allocators::mimalloc::heap_new() noexcept -> heap_t * {
+  return reinterpret_cast<heap_t *>(mi_heap_new());
+}
+
+void surge::allocators::mimalloc::heap_destroy(heap_t *h) noexcept {
+  if (h != nullptr) {
+    mi_heap_destroy(reinterpret_cast<mi_heap_t *>(h));
+  }
+}
+
+auto surge::allocators::mimalloc::heap_set_default(heap_t *h) noexcept -> heap_t * {
+  return reinterpret_cast<heap_t *>(mi_heap_set_default(reinterpret_cast<mi_heap_t *>(h)));
+}
+
+auto surge::allocators::mimalloc::heap_get_backing() noexcept -> heap_t * {
+  return reinterpret_cast<heap_t *>(mi_heap_get_backing());
+}
+
+static auto sum_heap_area(const mi_heap_t *, const mi_heap_area_t *area, void *, size_t,
+                          void *arg) -> bool {
+  if (area != nullptr) {
+    *static_cast<surge::usize *>(arg) += area->used * area->block_size;
+  }
+  return true;
+}
+
+auto surge::allocators::mimalloc::heap_used_bytes(const heap_t *h) noexcept -> usize {
+  usize used{0};
+  if (h != nullptr) {
+    mi_heap_visit_blocks(reinterpret_cast<const mi_heap_t *>(h), false, &sum_heap_area, &used);
+  }
+  return used;
+}
+
+/*
+ * Allocates the buffer of an engine arena, from the reserved arena memory when possible. Buffers
+ * are freed with mimalloc::aligned_free like any other heap block.
+ */
+static auto arena_memory_alloc(surge::usize size, surge::usize alignment) -> void * {
+  using namespace surge::allocators;
+
+  if (arena_memory_heap != nullptr) {
+    auto p{mi_heap_malloc_aligned(arena_memory_heap, size, alignment)};
+
+    if (p != nullptr) {
+      accounting::record_alloc(accounting::tag::general, mi_usable_size(p));
+#ifdef SURGE_DEBUG_MEMORY
+      trace::record_event(trace::op::alloc, accounting::tag::general, p, size);
+#endif
+      return p;
+    }
+  }
+
+  // Engine arenas outlive the module heaps that may be active when they grow
+  const mimalloc::heap_scope engine_heap{mimalloc::heap_get_backing()};
+  return mimalloc::aligned_alloc(size, alignment);
+}
+
 surge::allocators::mimalloc::arena::arena(usize cap) : data(cap, std::byte{0}), capacity{cap} {}
 
 void surge::allocators::mimalloc::arena::reset() {
-  log_info("Arena reset");
+#ifdef SURGE_DEBUG_MEMORY
+  trace::record_event(trace::op::arena_reset, accounting::tag::general, this, offset);
+#endif
   offset = 0;
+  padding = 0;
 }
 
 auto surge::allocators::mimalloc::arena::size() const -> usize { return offset; }
 
-static auto is_pow_2(surge::usize x) { return (x & (x - 1)) == 0; }
+auto surge::allocators::mimalloc::arena::wasted() const -> usize { return padding; }
+
+static auto is_pow_2(surge::usize x) { return x != 0 && (x & (x - 1)) == 0; }
+
+/*
+ * Returns the number of bytes that need to be skipped from address in order for it to be a multiple
+ * of alignment. alignment must be a power of 2.
+ */
+static auto align_padding(std::uintptr_t address, surge::usize alignment) -> surge::usize {
+  const auto mask{static_cast<std::uintptr_t>(alignment) - 1};
+  return static_cast<surge::usize>(((address + mask) & ~mask) - address);
+}
 
 auto surge::allocators::mimalloc::arena::allocate(usize size, usize alignment) -> void * {
   using std::memset;
@@ -154,73 +347,247 @@ auto surge::allocators::mimalloc::arena::allocate(usize size, usize alignment) -
     return nullptr;
   }
 
-  const auto modulo{size & (alignment - 1)}; // same as size % alignment when a is a power of 2
-  const auto actual_size{size + modulo};
-  const auto new_offset{offset + actual_size};
+  auto base{data.data()};
+  const auto pad{align_padding(reinterpret_cast<std::uintptr_t>(base + offset), alignment)};
+  const auto aligned_offset{offset + pad};
 
-  if (new_offset >= capacity) {
+  if (aligned_offset > capacity || size > capacity - aligned_offset) {
     log_warn("Unable to allocate {} B with {} B alignment. Arena is full", size, alignment);
     return nullptr;
   }
 
-  auto p{static_cast<void *>(&(data[offset]))};
-  offset = new_offset;
-  memset(p, 0, actual_size);
+  auto p{static_cast<void *>(base + aligned_offset)};
+  offset = aligned_offset + size;
+  padding += pad;
+  memset(p, 0, size);
 
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: alloc\n"
-            "allocator: \"mimalloc::arena\"\n"
-            "size: {}\n"
-            "alignment: {}\n"
-            "total aligned size: {}\n",
-            "address: {}\n"
-            "failed: {}",
-            size, alignment, actual_size, p, p ? "false" : "true");
+  trace::record_event(trace::op::arena_alloc, accounting::tag::general, p, size);
 #endif
 
   return p;
 }
 
+/*
+ * Each thread caches the sub-block it is currently carving from. The cache is only valid for the
+ * arena and reset epoch it was taken from, arenas being identified by a unique id rather than by
+ * address because a new arena may be constructed where an old one lived.
+ */
+struct concurrent_arena_cache {
+  surge::u64 arena_id{0};
+  surge::u64 epoch{0};
+  std::byte *cursor{nullptr};
+  std::byte *end{nullptr};
+};
+
+static std::atomic<surge::u64> concurrent_arena_ids{0};
+static thread_local concurrent_arena_cache concurrent_cache{};
+
+static auto round_up(surge::usize x, surge::usize multiple) -> surge::usize {
+  return ((x + multiple - 1) / multiple) * multiple;
+}
+
+// Executor workers of every priority class, plus the main thread, stay below this many per core
+static constexpr surge::usize concurrent_threads_per_core{2};
+
+surge::allocators::mimalloc::concurrent_arena::concurrent_arena(usize cap, usize sub_block)
+    : id{concurrent_arena_ids.fetch_add(1, std::memory_order_relaxed) + 1} {
+
+  // Whole cache lines only, so that offsets stay cache line aligned
+  const auto rounded_cap{round_up(cap == 0 ? cache_line_size : cap, cache_line_size)};
+
+  // Sized so every expected thread can hold a sub-block from the first half of the arena
+  const auto threads{concurrent_threads_per_core
+                     * std::max(usize{std::thread::hardware_concurrency()}, usize{1})};
+  const auto share{rounded_cap / (2 * threads) / cache_line_size * cache_line_size};
+
+  const auto requested{round_up(sub_block == 0 ? cache_line_size : sub_block, cache_line_size)};
+  sub_block_size = std::max(std::min(requested, share), cache_line_size);
+
+  data = static_cast<std::byte *>(arena_memory_alloc(rounded_cap, cache_line_size));
+
+  if (data == nullptr) {
+    log_error("Unable to allocate {} B for concurrent arena", rounded_cap);
+  } else {
+    capacity = rounded_cap;
+  }
+}
+
+surge::allocators::mimalloc::concurrent_arena::~concurrent_arena() {
+  if (data != nullptr) {
+    mimalloc::aligned_free(data, cache_line_size);
+  }
+}
+
+auto surge::allocators::mimalloc::concurrent_arena::reserve(usize bytes) -> std::byte * {
+  // A reservation that does not fit leaves the offset untouched, so the tail stays available to
+  // smaller requests
+  auto start{offset.load(std::memory_order_relaxed)};
+
+  do {
+    if (start > capacity || bytes > capacity - start) {
+      return nullptr;
+    }
+  } while (!offset.compare_exchange_weak(start, start + bytes, std::memory_order_relaxed));
+
+  return data + start;
+}
+
+auto surge::allocators::mimalloc::concurrent_arena::reserve_exact(usize size, usize alignment)
+    -> void * {
+  // Offsets stay multiples of the cache line size, so only alignments beyond it need extra room
+  const auto extra{alignment > cache_line_size ? alignment - cache_line_size : 0};
+  auto block{reserve(round_up(size + extra, cache_line_size))};
+
+  if (block == nullptr) {
+    log_warn("Unable to allocate {} B with {} B alignment. Concurrent arena is full", size,
+             alignment);
+    return nullptr;
+  }
+
+  return block + align_padding(reinterpret_cast<std::uintptr_t>(block), alignment);
+}
+
+auto surge::allocators::mimalloc::concurrent_arena::allocate(usize size, usize alignment)
+    -> void * {
+  if (!is_pow_2(alignment)) {
+    log_error("Alignment {} is not a power of 2", alignment);
+    return nullptr;
+  }
+
+  // Large requests bypass the thread cache
+  if (size > sub_block_size / 2 || alignment > sub_block_size / 2 - size) {
+    return reserve_exact(size, alignment);
+  }
+
+  auto &cache{concurrent_cache};
+  const auto current_epoch{epoch.load(std::memory_order_acquire)};
+
+  if (cache.arena_id != id || cache.epoch != current_epoch) {
+    cache = concurrent_arena_cache{id, current_epoch, nullptr, nullptr};
+  }
+
+  auto pad{align_padding(reinterpret_cast<std::uintptr_t>(cache.cursor), alignment)};
+
+  if (cache.cursor == nullptr || pad > static_cast<usize>(cache.end - cache.cursor)
+      || size > static_cast<usize>(cache.end - cache.cursor) - pad) {
+    // Sub-blocks only come from the first half of the arena. Past it, requests take only what
+    // they need, so threads arriving late still find room
+    const bool first_half{offset.load(std::memory_order_relaxed) <= capacity / 2};
+    auto block{first_half ? reserve(sub_block_size) : nullptr};
+
+    if (block == nullptr) {
+      return reserve_exact(size, alignment);
+    }
+
+    cache.cursor = block;
+    cache.end = block + sub_block_size;
+    pad = align_padding(reinterpret_cast<std::uintptr_t>(block), alignment);
+  }
+
+  auto p{cache.cursor + pad};
+  cache.cursor = p + size;
+
+  return p;
+}
+
+void surge::allocators::mimalloc::concurrent_arena::reset() {
+  offset.store(0, std::memory_order_relaxed);
+  epoch.fetch_add(1, std::memory_order_release);
+}
+
+auto surge::allocators::mimalloc::concurrent_arena::size() const -> usize {
+  return offset.load(std::memory_order_relaxed);
+}
+
 namespace surge::allocators {
 
+/**
+ * A block of memory owned by a dynamic arena. The usable bytes follow the header directly.
+ */
+struct alignas(std::max_align_t) arena_chunk {
+  arena_chunk *next{nullptr};
+  usize capacity{0};
+  usize offset{0};
+
+  inline auto data() noexcept -> std::byte * { return reinterpret_cast<std::byte *>(this + 1); }
+};
+
 /**
  * This is a CPU memory arena that grows when needed.
+ *
+ * Growing never moves previous allocations: a new chunk is linked after the current one and
+ * allocations continue from there. Resetting rewinds the arena to the first chunk while keeping all
+ * chunks around for reuse.
  */
 struct dynamic_arena {
-  usize current_capacity{0};
-  usize current_offset{0};
+  usize total_capacity{0};
+  usize used_bytes{0};
+  usize wasted_bytes{0};
   const char *arena_name{nullptr};
-  std::byte *memory_data{nullptr};
+  arena_chunk *first_chunk{nullptr};
+  arena_chunk *current_chunk{nullptr};
 };
 
+static auto dynamic_arena_new_chunk(usize capacity) -> arena_chunk * {
+  auto memory{arena_memory_alloc(sizeof(arena_chunk) + capacity, alignof(arena_chunk))};
+
+  if (memory == nullptr) {
+    return nullptr;
+  }
+
+  return new (memory) arena_chunk{.next = nullptr, .capacity = capacity, .offset = 0};
+}
+
 static auto dynamic_arena_init(usize initial_size, const char *arena_name)
     -> tl::expected<dynamic_arena, error> {
-  using std::memset;
-
   log_info("Allocating initial {} B for arena \"{}\"", initial_size, arena_name);
 
-  auto memory_data = static_cast<std::byte *>(mimalloc::malloc(initial_size));
+  auto chunk{dynamic_arena_new_chunk(initial_size)};
 
-  if (memory_data == nullptr) {
+  if (chunk == nullptr) {
     log_error("Unable to initially allocate {} B for arena \"{}\"", initial_size, arena_name);
     return tl::unexpected{error::dynamic_arena_init};
   }
 
-  memset(memory_data, 0, initial_size);
   log_info("Arena \"{}\" ready to operate with initial {} B of capacity", arena_name, initial_size);
 
-  return dynamic_arena{.current_capacity = initial_size,
-                       .current_offset = 0,
+  return dynamic_arena{.total_capacity = initial_size,
+                       .used_bytes = 0,
+                       .wasted_bytes = 0,
                        .arena_name = arena_name,
-                       .memory_data = memory_data};
+                       .first_chunk = chunk,
+                       .current_chunk = chunk};
 }
 
 static void dynamic_arena_destroy(dynamic_arena &da) {
-  log_info("Deallocating arena \"{}\" with current size {}, current capacity {}", da.arena_name,
-           da.current_offset, da.current_capacity);
-  mimalloc::free(da.memory_data);
+  log_info("Deallocating arena \"{}\" with total capacity {}, wasted {} B", da.arena_name,
+           da.total_capacity, da.wasted_bytes);
+
+  auto chunk{da.first_chunk};
+  while (chunk != nullptr) {
+    auto next{chunk->next};
+    mimalloc::aligned_free(chunk, alignof(arena_chunk));
+    chunk = next;
+  }
+
+  da.total_capacity = 0;
+  da.used_bytes = 0;
+  da.wasted_bytes = 0;
+  da.first_chunk = nullptr;
+  da.current_chunk = nullptr;
+}
+
+static auto chunk_fit(arena_chunk *chunk, usize size, usize alignment) -> std::optional<usize> {
+  const auto pad{
+      align_padding(reinterpret_cast<std::uintptr_t>(chunk->data() + chunk->offset), alignment)};
+  const auto aligned_offset{chunk->offset + pad};
+
+  if (aligned_offset > chunk->capacity || size > chunk->capacity - aligned_offset) {
+    return {};
+  }
+
+  return pad;
 }
 
 static auto dynamic_arena_malloc(dynamic_arena &da, usize size, usize alignment)
@@ -233,49 +600,66 @@ static auto dynamic_arena_malloc(dynamic_arena &da, usize size, usize alignment)
     return tl::unexpected{error::dynamic_arena_alloc};
   }
 
-  const auto modulo{size & (alignment - 1)}; // same as size % alignment when a is a power of 2
-  const auto actual_size{size + modulo};
-  const auto new_offset{da.current_offset + actual_size};
+  auto pad{chunk_fit(da.current_chunk, size, alignment)};
+
+  // Try the next chunk left over from before a reset
+  if (!pad && da.current_chunk->next != nullptr) {
+    auto next{da.current_chunk->next};
+    next->offset = 0;
+    pad = chunk_fit(next, size, alignment);
+
+    if (pad) {
+      da.current_chunk = next;
+    }
+  }
 
-  if (new_offset >= da.current_capacity) {
-    const auto new_capacity{da.current_capacity * 2};
+  // Link a new chunk after the current one. Nothing is copied, so previous pointers stay valid
+  if (!pad) {
+    // Doubles the capacity, or more when the request would not fit. The size term also keeps
+    // arenas created with no capacity growing
+    const auto new_capacity{std::max(da.current_chunk->capacity * 2, size + alignment)};
 
-    log_info("Growing arena \"{}\" from {} B to {} B of capacity", da.arena_name,
-             da.current_capacity, new_capacity);
+    log_info("Growing arena \"{}\" by {} B of capacity", da.arena_name, new_capacity);
 
-    auto new_memory_data{static_cast<std::byte *>(mimalloc::malloc(new_capacity))};
+    auto chunk{dynamic_arena_new_chunk(new_capacity)};
 
-    if (new_memory_data == nullptr) {
+    if (chunk == nullptr) {
       log_error("Failed to grow arena \"{}\"", da.arena_name);
       return tl::unexpected{dynamic_arena_grow};
     }
 
-    memcpy(new_memory_data, da.memory_data, da.current_offset);
-    mimalloc::free(da.memory_data);
+    chunk->next = da.current_chunk->next;
+    da.current_chunk->next = chunk;
+    da.current_chunk = chunk;
+    da.total_capacity += new_capacity;
 
-    da.current_capacity = new_capacity;
-    da.memory_data = new_memory_data;
+    pad = chunk_fit(chunk, size, alignment);
   }
 
-  auto p{static_cast<void *>(&(da.memory_data[da.current_offset]))};
-  da.current_offset = new_offset;
-  memset(p, 0, actual_size);
+  auto chunk{da.current_chunk};
+  auto p{static_cast<void *>(chunk->data() + chunk->offset + *pad)};
+  chunk->offset += *pad + size;
+  da.used_bytes += *pad + size;
+  da.wasted_bytes += *pad;
+  memset(p, 0, size);
 
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Memory Event\n"
-            "---\n"
-            "type: alloc\n"
-            "allocator: \"{}\"\n "
-            "size: {}\n"
-            "alignment: {}\n"
-            "total aligned size: {}\n",
-            "address: {}\n", da.arena_name, size, alignment, actual_size, p);
+  trace::record_event(trace::op::arena_alloc, accounting::tag::general, p, size);
 #endif
 
   return p;
 }
 
-static void dynamic_arena_reset(dynamic_arena &da) { da.current_offset = 0; }
+static void dynamic_arena_reset(dynamic_arena &da) {
+#ifdef SURGE_DEBUG_MEMORY
+  trace::record_event(trace::op::arena_reset, accounting::tag::general, &da, da.used_bytes);
+#endif
+
+  da.first_chunk->offset = 0;
+  da.current_chunk = da.first_chunk;
+  da.used_bytes = 0;
+  da.wasted_bytes = 0;
+}
 
 static dynamic_arena program_scope_dynamic_arena{};
 
@@ -289,6 +673,7 @@ auto program_scope::init() -> tl::expected<void, surge::error> {
     return tl::unexpected{da.error()};
   } else {
     program_scope_dynamic_arena = *da;
+    return {};
   }
 }
 
@@ -301,4 +686,104 @@ auto program_scope::malloc(usize size, usize alignment) -> tl::expected<void *,
   return dynamic_arena_malloc(program_scope_dynamic_arena, size, alignment);
 }
 
+/*
+ * Frame scope arenas are used in a ring. Memory allocated during a frame stays valid until the ring
+ * wraps around and the same arena is reused, redundancy - 1 frames later.
+ */
+static std::vector<dynamic_arena, mimalloc::cpp_allocator<dynamic_arena>> frame_scope_arenas{};
+static usize frame_scope_current{0};
+static frame_scope::stats frame_scope_stats{};
+
+static std::deque<mimalloc::concurrent_arena, mimalloc::cpp_allocator<mimalloc::concurrent_arena>>
+    frame_scope_concurrent_arenas{};
+
+auto frame_scope::init(usize capacity, usize redundancy) -> tl::expected<void, surge::error> {
+  log_info("Initializing frame scope CPU memory arenas");
+
+  if (redundancy == 0) {
+    log_error("Unable to initialize frame scope CPU memory arenas: Redundancy must be at least 1");
+    return tl::unexpected{error::dynamic_arena_init};
+  }
+
+  frame_scope_arenas.reserve(redundancy);
+
+  for (usize i = 0; i < redundancy; i++) {
+    auto da{dynamic_arena_init(capacity, "Frame scope arena")};
+
+    if (!da) {
+      log_error("Unable to initialize frame scope CPU memory arena {}", i);
+      destroy();
+      return tl::unexpected{da.error()};
+    }
+
+    frame_scope_arenas.push_back(*da);
+    frame_scope_concurrent_arenas.emplace_back(capacity);
+
+    if (!frame_scope_concurrent_arenas.back().valid()) {
+      log_error("Unable to initialize frame scope concurrent CPU memory arena {}", i);
+      destroy();
+      return tl::unexpected{error::dynamic_arena_init};
+    }
+  }
+
+  frame_scope_current = 0;
+  frame_scope_stats = stats{};
+
+  return {};
+}
+
+void frame_scope::destroy() {
+  log_info("Destroying frame scope CPU memory arenas. High water mark: {} B",
+           frame_scope_stats.high_water_mark);
+
+  for (auto &da : frame_scope_arenas) {
+    dynamic_arena_destroy(da);
+  }
+
+  frame_scope_arenas.clear();
+  frame_scope_concurrent_arenas.clear();
+}
+
+void frame_scope::advance() {
+  auto &current{frame_scope_arenas[frame_scope_current]};
+
+  frame_scope_stats.last_frame_usage = current.used_bytes;
+  if (current.used_bytes > frame_scope_stats.high_water_mark) {
+    frame_scope_stats.high_water_mark = current.used_bytes;
+  }
+
+  frame_scope_current = (frame_scope_current + 1) % frame_scope_arenas.size();
+  dynamic_arena_reset(frame_scope_arenas[frame_scope_current]);
+  frame_scope_concurrent_arenas[frame_scope_current].reset();
+
+  frame_scope_stats.frame_index++;
+}
+
+auto frame_scope::malloc(usize size, usize alignment) -> tl::expected<void *, error> {
+  return dynamic_arena_malloc(frame_scope_arenas[frame_scope_current], size, alignment);
+}
+
+auto frame_scope::concurrent_malloc(usize size, usize alignment) -> tl::expected<void *, error> {
+  auto p{frame_scope_concurrent_arenas[frame_scope_current].allocate(size, alignment)};
+
+  if (p == nullptr) {
+    return tl::unexpected{error::dynamic_arena_alloc};
+  }
+
+  return p;
+}
+
+auto frame_scope::get_stats() -> stats {
+  auto s{frame_scope_stats};
+  s.frame_usage = frame_scope_arenas[frame_scope_current].used_bytes;
+  s.concurrent_usage = frame_scope_concurrent_arenas[frame_scope_current].size();
+  s.capacity = 0;
+
+  for (const auto &da : frame_scope_arenas) {
+    s.capacity += da.total_capacity;
+  }
+
+  return s;
+}
+
 } // namespace surge::allocators
\ No newline at end of file
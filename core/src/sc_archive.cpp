@@ -0,0 +1,431 @@
+#include "sc_archive.hpp"
+
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_logging.hpp"
+#include "sc_options.hpp"
+#include "sc_tasks.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <xxhash.h>
+#include <zstd.h>
+
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+static_assert(std::endian::native == std::endian::little,
+              "Asset packs are read in place and assume a little endian host");
+
+static constexpr XXH64_hash_t archive_hash_seed{0};
+
+auto surge::files::archive_hash(std::string_view name) noexcept -> u64 {
+  return XXH64(name.data(), name.size(), archive_hash_seed);
+}
+
+// Checks that [offset, offset + size) lies inside a pack of pack_size bytes, without overflowing
+static auto in_bounds(surge::u64 offset, surge::u64 size, surge::u64 pack_size) noexcept -> bool {
+  return offset <= pack_size && size <= pack_size - offset;
+}
+
+// Rounds up without computing size + chunk_size - 1, which wraps for sizes read from a corrupt pack
+static auto chunk_count(surge::u64 size, surge::u32 chunk_size) noexcept -> surge::u64 {
+  return size / chunk_size + (size % chunk_size != 0 ? 1 : 0);
+}
+
+// Checks that chunks chunks of chunk_size bytes hold size bytes, without overflowing
+static auto chunks_hold(surge::u64 size, surge::u32 chunk_size, surge::u64 chunks) noexcept
+    -> bool {
+  return chunks <= std::numeric_limits<surge::u64>::max() / chunk_size
+         && size <= chunks * chunk_size;
+}
+
+/*
+ * Largest decompressed to stored size ratio an entry may claim. Zstd, the codec that compresses
+ * the most, stores every block of at most 128 KiB in no less than 4 bytes, so real payloads stay
+ * under 32768:1. Corrupt entries claiming more are rejected instead of making readers allocate
+ * absurd buffers.
+ */
+static constexpr surge::u64 max_compression_ratio{1 << 16};
+
+// Packs are built once and read many times, so compression time is traded for size
+static constexpr int zstd_pack_level{19};
+
+static auto compress_chunk(surge::files::compression method, std::span<const std::byte> in,
+                           surge::vector<std::byte> &out) -> bool {
+  using namespace surge;
+
+  switch (method) {
+  case files::compression::lz4: {
+    const auto in_size{static_cast<int>(in.size())};
+    out.resize(static_cast<usize>(LZ4_compressBound(in_size)));
+    const auto n{LZ4_compress_HC(reinterpret_cast<const char *>(in.data()),  // NOLINT
+                                 reinterpret_cast<char *>(out.data()), in_size, // NOLINT
+                                 static_cast<int>(out.size()), LZ4HC_CLEVEL_DEFAULT)};
+    out.resize(static_cast<usize>(n));
+    return n > 0;
+  }
+
+  case files::compression::zstd: {
+    out.resize(ZSTD_compressBound(in.size()));
+    const auto n{ZSTD_compress(out.data(), out.size(), in.data(), in.size(), zstd_pack_level)};
+    if (ZSTD_isError(n) != 0) {
+      return false;
+    }
+    out.resize(n);
+    return true;
+  }
+
+  default:
+    return false;
+  }
+}
+
+// One decompression context per thread, reused by every Zstd chunk the thread decompresses
+struct zstd_context {
+  ZSTD_DCtx *ctx{ZSTD_createDCtx()};
+
+  zstd_context() = default;
+  ~zstd_context() { ZSTD_freeDCtx(ctx); }
+
+  zstd_context(const zstd_context &) = delete;
+  auto operator=(const zstd_context &) -> zstd_context & = delete;
+};
+
+static auto decompress_chunk(surge::files::compression method, std::span<const std::byte> in,
+                             std::span<std::byte> out) -> bool {
+  using namespace surge;
+
+  switch (method) {
+  case files::compression::lz4: {
+    const auto n{LZ4_decompress_safe(reinterpret_cast<const char *>(in.data()), // NOLINT
+                                     reinterpret_cast<char *>(out.data()),      // NOLINT
+                                     static_cast<int>(in.size()), static_cast<int>(out.size()))};
+    return n >= 0 && static_cast<usize>(n) == out.size();
+  }
+
+  case files::compression::zstd: {
+    thread_local zstd_context zstd{};
+    if (zstd.ctx == nullptr) {
+      return false;
+    }
+
+    const auto n{ZSTD_decompressDCtx(zstd.ctx, out.data(), out.size(), in.data(), in.size())};
+    return ZSTD_isError(n) == 0 && n == out.size();
+  }
+
+  default:
+    return false;
+  }
+}
+
+auto surge::files::compress_payload(compression method, u32 chunk_size,
+                                    std::span<const std::byte> bytes)
+    -> tl::expected<vector<std::byte>, error> {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::files::compress_payload");
+#endif
+
+  if (method == compression::none || chunk_size == 0
+      || chunk_size > static_cast<u32>(LZ4_MAX_INPUT_SIZE)) {
+    return tl::unexpected{error::invalid_format};
+  }
+
+  const auto chunks{static_cast<usize>(chunk_count(bytes.size(), chunk_size))};
+  vector<vector<std::byte>> compressed(chunks);
+  std::atomic<bool> failed{false};
+
+  tasks::parallel_for(0, chunks, 1, [&](usize c) {
+    const auto first{c * chunk_size};
+    const auto in{bytes.subspan(first, std::min(usize{chunk_size}, bytes.size() - first))};
+    if (!compress_chunk(method, in, compressed[c])) {
+      failed.store(true, std::memory_order_relaxed);
+    }
+  });
+
+  if (failed.load(std::memory_order_relaxed)) {
+    log_error("Unable to compress an asset payload");
+    return tl::unexpected{error::compression_error};
+  }
+
+  // Chunk table, then the chunks
+  vector<std::byte> payload(chunks * sizeof(u64));
+  u64 end{0};
+
+  for (usize c = 0; c < chunks; c++) {
+    end += compressed[c].size();
+    std::memcpy(payload.data() + c * sizeof(u64), &end, sizeof(u64));
+  }
+
+  payload.reserve(payload.size() + end);
+  for (const auto &chunk : compressed) {
+    payload.insert(payload.end(), chunk.begin(), chunk.end());
+  }
+
+  return payload;
+}
+
+auto surge::files::decompress_payload(compression method, u32 chunk_size,
+                                      std::span<const std::byte> payload, std::span<std::byte> out)
+    -> std::optional<error> {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::files::decompress_payload");
+#endif
+
+  if (chunk_size == 0) {
+    return error::compression_error;
+  }
+
+  const auto chunks{static_cast<usize>(chunk_count(out.size(), chunk_size))};
+  if (payload.size() / sizeof(u64) < chunks) {
+    return error::compression_error;
+  }
+
+  const auto table{payload.first(chunks * sizeof(u64))};
+  const auto data{payload.subspan(table.size())};
+  std::atomic<bool> failed{false};
+
+  tasks::parallel_for(0, chunks, 1, [&](usize c) {
+    tasks::yield_to_frame();
+
+    u64 begin{0};
+    u64 end{0};
+    if (c > 0) {
+      std::memcpy(&begin, table.data() + (c - 1) * sizeof(u64), sizeof(u64));
+    }
+    std::memcpy(&end, table.data() + c * sizeof(u64), sizeof(u64));
+
+    // Chunk bounds come from the pack, so they are checked before use
+    if (begin > end || end > data.size()) {
+      failed.store(true, std::memory_order_relaxed);
+      return;
+    }
+
+    const auto first{c * chunk_size};
+    const auto in{data.subspan(static_cast<usize>(begin), static_cast<usize>(end - begin))};
+    const auto dst{out.subspan(first, std::min(usize{chunk_size}, out.size() - first))};
+
+    if (!decompress_chunk(method, in, dst)) {
+      failed.store(true, std::memory_order_relaxed);
+    }
+  });
+
+  if (failed.load(std::memory_order_relaxed)) {
+    return error::compression_error;
+  }
+
+  return {};
+}
+
+auto surge::files::archive::open(const char *path) -> tl::expected<archive, error> {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::files::archive::open");
+#endif
+
+  log_info("Opening asset pack {}", path);
+
+  auto pack_file{files::map_file(path)};
+  if (!pack_file) {
+    log_error("Unable to open asset pack {}", path);
+    return tl::unexpected{pack_file.error()};
+  }
+
+  const auto bytes{pack_file->view()};
+  const auto pack_size{static_cast<u64>(bytes.size())};
+
+  archive_header header{};
+  const archive_header expected_header{};
+
+  if (bytes.size() < sizeof(header)) {
+    log_error("{} is too short to be an asset pack", path);
+    return tl::unexpected{error::invalid_format};
+  }
+
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, expected_header.magic, sizeof(header.magic)) != 0
+      || header.version != expected_header.version || header.entry_size != sizeof(archive_entry)
+      || header.index_offset % alignof(archive_entry) != 0
+      || header.entry_count > pack_size / sizeof(archive_entry)
+      || !in_bounds(header.index_offset, header.entry_count * sizeof(archive_entry), pack_size)
+      || !in_bounds(header.names_offset, 0, pack_size)) {
+    log_error("{} is not an asset pack this engine understands", path);
+    return tl::unexpected{error::invalid_format};
+  }
+
+  archive a{};
+  a.index = {reinterpret_cast<const archive_entry *>(bytes.data() + header.index_offset), // NOLINT
+             static_cast<usize>(header.entry_count)};
+  a.names = {reinterpret_cast<const char *>(bytes.data() + header.names_offset), // NOLINT
+             static_cast<usize>(pack_size - header.names_offset)};
+
+  // Entries are checked once here, so lookups can trust them
+  for (usize i = 0; i < a.index.size(); i++) {
+    const auto &e{a.index[i]};
+
+    const bool sorted{i == 0 || a.index[i - 1].name_hash <= e.name_hash};
+    const bool payload_ok{in_bounds(e.offset, e.stored_size, pack_size)};
+    const bool name_ok{in_bounds(e.name_offset, e.name_length, a.names.size())};
+    const bool stored_ok{e.method == compression::none && e.stored_size == e.size};
+    const bool compressed_ok{(e.method == compression::lz4 || e.method == compression::zstd)
+                             && e.chunk_size != 0
+                             && e.size / max_compression_ratio <= e.stored_size
+                             && chunks_hold(e.size, e.chunk_size, chunk_count(e.size, e.chunk_size))
+                             && e.stored_size / sizeof(u64) >= chunk_count(e.size, e.chunk_size)};
+    const bool method_ok{stored_ok || compressed_ok};
+
+    if (!sorted || !payload_ok || !name_ok || !method_ok) {
+      log_error("Asset pack {} has a corrupt entry at index {}", path, i);
+      return tl::unexpected{error::invalid_format};
+    }
+  }
+
+  a.pack = std::move(*pack_file);
+
+  log_info("Opened asset pack {} with {} entries", path, a.index.size());
+  return a;
+}
+
+auto surge::files::archive::find(std::string_view name) const noexcept -> const archive_entry * {
+  const auto hash{archive_hash(name)};
+
+  auto it{std::lower_bound(index.begin(), index.end(), hash,
+                           [](const archive_entry &e, u64 h) { return e.name_hash < h; })};
+
+  for (; it != index.end() && it->name_hash == hash; ++it) {
+    if (this->name(*it) == name) {
+      return &(*it);
+    }
+  }
+
+  return nullptr;
+}
+
+auto surge::files::archive::name(const archive_entry &e) const noexcept -> std::string_view {
+  return {names.data() + e.name_offset, e.name_length};
+}
+
+auto surge::files::archive::payload(const archive_entry &e) const noexcept
+    -> std::span<const std::byte> {
+  return pack.view().subspan(static_cast<usize>(e.offset), static_cast<usize>(e.stored_size));
+}
+
+auto surge::files::archive::read(const archive_entry &e, bool append_null_byte) const -> file {
+  const auto p{payload(e)};
+
+  // Buffers are sized from the index, so a large entry can fail to allocate
+  try {
+    if (e.method != compression::none) {
+      file_data_t buffer(static_cast<usize>(append_null_byte ? e.size + 1 : e.size));
+
+      const auto err{decompress_payload(e.method, e.chunk_size, p,
+                                        std::span{buffer}.first(static_cast<usize>(e.size)))};
+      if (err) {
+        log_error("Unable to decompress {} from asset pack", name(e));
+        return tl::unexpected{*err};
+      }
+
+      return buffer;
+    }
+
+    file_data_t buffer{};
+    buffer.reserve(append_null_byte ? p.size() + 1 : p.size());
+    buffer.insert(buffer.end(), p.begin(), p.end());
+
+    if (append_null_byte) {
+      buffer.push_back(std::byte{0});
+    }
+
+    return buffer;
+
+  } catch (const std::exception &ex) {
+    log_error("Unable to read {} from asset pack: {}", name(e), ex.what());
+    return tl::unexpected{error::unknow_error};
+  }
+}
+
+auto surge::files::archive::map(const archive_entry &e) const -> mapping {
+  if (e.method != compression::none) {
+    auto buffer{read(e, false)};
+    if (!buffer) {
+      return tl::unexpected{buffer.error()};
+    }
+    return mapped_file{std::move(*buffer)};
+  }
+
+  const auto p{payload(e)};
+  return mapped_file{p.data(), p.size(), true};
+}
+
+auto surge::files::archive::load_file(std::string_view name, bool append_null_byte) const
+    -> file {
+  const auto e{find(name)};
+  if (e == nullptr) {
+    log_error("The asset pack has no entry named {}", name);
+    return tl::unexpected{error::invalid_path};
+  }
+  return read(*e, append_null_byte);
+}
+
+auto surge::files::archive::map_file(std::string_view name) const -> mapping {
+  const auto e{find(name)};
+  if (e == nullptr) {
+    log_error("The asset pack has no entry named {}", name);
+    return tl::unexpected{error::invalid_path};
+  }
+  return map(*e);
+}
+
+auto surge::files::archive::load_image(const char *name, bool flip) const -> image {
+  log_info("Loading image {} from asset pack", name);
+
+  const auto file{map_file(name)};
+  if (!file) {
+    return tl::unexpected(error::image_load_error);
+  }
+
+  return decode_image(name, file->view(), flip);
+}
+
+/*
+ * Mounted packs, searched last to first
+ */
+static surge::vector<surge::files::archive> mounted_packs{};
+
+auto surge::files::mount(const char *path) -> std::optional<error> {
+  // Packs outlive any module heap
+  const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+
+  auto pack{archive::open(path)};
+  if (!pack) {
+    return pack.error();
+  }
+
+  mounted_packs.push_back(std::move(*pack));
+  log_info("Mounted asset pack {}", path);
+  return {};
+}
+
+void surge::files::unmount_all() {
+  const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+  mounted_packs.clear();
+}
+
+auto surge::files::find_mounted(std::string_view name) noexcept -> std::optional<mounted_entry> {
+  for (auto it = mounted_packs.rbegin(); it != mounted_packs.rend(); ++it) {
+    if (const auto e{it->find(name)}; e != nullptr) {
+      return mounted_entry{&(*it), e};
+    }
+  }
+  return {};
+}
\ No newline at end of file
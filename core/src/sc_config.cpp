@@ -5,7 +5,9 @@
 #include "sc_logging.hpp"
 
 #include <array>
+#include <charconv>
 #include <cstring>
+#include <string_view>
 #include <ryml/ryml.hpp>
 
 static void ryml_error(const char *msg, size_t, ryml::Location location, void *) {
@@ -18,16 +20,70 @@ static void ryml_error(const char *msg, size_t, ryml::Location location, void *)
 }
 
 static auto ryml_alloc(size_t len, void *, void *) -> void * {
-  return surge::allocators::mimalloc::malloc(len);
+  return surge::allocators::mimalloc::malloc(len, surge::allocators::accounting::tag::config);
 }
 
-static void ryml_free(void *mem, size_t, void *) { surge::allocators::mimalloc::free(mem); }
+static void ryml_free(void *mem, size_t, void *) {
+  surge::allocators::mimalloc::free(mem, surge::allocators::accounting::tag::config);
+}
+
+/*
+ * Parses a CPU list such as "0-3,8,10-11". Returns an empty set, which means "no restriction",
+ * when the list is malformed or names a CPU past max_cpus.
+ */
+static auto parse_cpu_list(std::string_view list) -> surge::config::cpu_set {
+  using surge::config::cpu_set;
+  using surge::config::max_cpus;
+
+  cpu_set cpus{};
+
+  while (!list.empty()) {
+    const auto comma{list.find(',')};
+    const auto item{list.substr(0, comma)};
+    list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+    const auto dash{item.find('-')};
+    const auto first_str{item.substr(0, dash)};
+    const auto last_str{dash == std::string_view::npos ? first_str : item.substr(dash + 1)};
+
+    surge::usize first{0};
+    surge::usize last{0};
+    const auto first_res{std::from_chars(first_str.data(), first_str.data() + first_str.size(),
+                                         first)};
+    const auto last_res{std::from_chars(last_str.data(), last_str.data() + last_str.size(), last)};
+
+    if (first_res.ec != std::errc{} || last_res.ec != std::errc{} || first_str.empty()
+        || last_str.empty() || first > last || last >= max_cpus) {
+      log_warn("Ignoring invalid CPU list entry \"{}\" in config.yaml", item);
+      return cpu_set{};
+    }
+
+    for (auto cpu = first; cpu <= last; cpu++) {
+      cpus.set(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+static auto parse_priority(std::string_view name) -> surge::config::thread_priority {
+  using surge::config::thread_priority;
+
+  if (name == "low") {
+    return thread_priority::low;
+  } else if (name == "high") {
+    return thread_priority::high;
+  } else if (name != "normal") {
+    log_warn("Unknown worker priority \"{}\" in config.yaml. Using normal", name);
+  }
+  return thread_priority::normal;
+}
 
 auto surge::config::parse_config(renderer_backend backend) -> tl::expected<config_data, error> {
   using std::atof;
   using std::atoi;
 
-  auto config_file{files::load_file("config.yaml", true)};
+  const auto config_file{files::map_file("config.yaml")};
 
   if (!config_file) {
     log_error("Unable to load config.yaml file");
@@ -35,7 +91,8 @@ auto surge::config::parse_config(renderer_backend backend) -> tl::expected<confi
   }
 
   config_data cd{};
-  const auto file_str{reinterpret_cast<const char *>(config_file->data())};
+  const ryml::csubstr file_str{reinterpret_cast<const char *>(config_file->data()), // NOLINT
+                               config_file->size()};
 
   try {
     const ryml::Callbacks callbacks{nullptr, &ryml_alloc, &ryml_free, &ryml_error};
@@ -50,8 +107,8 @@ auto surge::config::parse_config(renderer_backend backend) -> tl::expected<confi
     cd.ccl.b = strtof(tree["clear_color"]["b"].val().data(), nullptr);
     cd.ccl.a = strtof(tree["clear_color"]["a"].val().data(), nullptr);
 
-    cd.wattrs.name
-        = string(tree["window"]["name"].val().data(), tree["window"]["name"].val().size());
+    cd.wattrs.name = std::string_view{tree["window"]["name"].val().data(),
+                                      tree["window"]["name"].val().size()};
     cd.wattrs.monitor_index = atoi(tree["window"]["monitor_index"].val().data());
     cd.wattrs.windowed = static_cast<bool>(atoi(tree["window"]["windowed"].val().data()));
     cd.wattrs.cursor = static_cast<bool>(atoi(tree["window"]["windowed"].val().data()));
@@ -62,8 +119,63 @@ auto surge::config::parse_config(renderer_backend backend) -> tl::expected<confi
     cd.rattrs.fps_cap = static_cast<bool>(atoi(tree["renderer"]["fps_cap"].val().data()));
     cd.rattrs.fps_cap_value = atoi(tree["renderer"]["fps_cap_value"].val().data());
 
-    cd.module = string(tree["modules"]["first_module"].val().data(),
-                       tree["modules"]["first_module"].val().size());
+    if (cd.rattrs.fps_cap_value <= 0) {
+      log_warn("Invalid fps_cap_value {} in config.yaml. Using 60", cd.rattrs.fps_cap_value);
+      cd.rattrs.fps_cap_value = 60;
+    }
+
+    cd.module = std::string_view{tree["modules"]["first_module"].val().data(),
+                                 tree["modules"]["first_module"].val().size()};
+
+    // The memory section is optional
+    if (tree.rootref().has_child("memory")) {
+      const auto memory{tree["memory"]};
+
+      cd.mattrs.huge_pages = static_cast<bool>(atoi(memory["huge_pages"].val().data()));
+
+      const auto arena_memory_mb{strtoull(memory["arena_memory_mb"].val().data(), nullptr, 10)};
+      if (arena_memory_mb > max_arena_memory_size / (1024 * 1024)) {
+        log_warn("arena_memory_mb in config.yaml is too large. Using {} MiB",
+                 max_arena_memory_size / (1024 * 1024));
+        cd.mattrs.arena_memory_size = max_arena_memory_size;
+      } else {
+        cd.mattrs.arena_memory_size = arena_memory_mb * 1024 * 1024;
+      }
+
+      const auto frame_arena_kb{strtoull(memory["frame_arena_kb"].val().data(), nullptr, 10)};
+      if (frame_arena_kb > max_frame_arena_size / 1024) {
+        log_warn("frame_arena_kb in config.yaml is too large. Using {} KiB",
+                 max_frame_arena_size / 1024);
+        cd.mattrs.frame_arena_size = max_frame_arena_size;
+      } else {
+        cd.mattrs.frame_arena_size = frame_arena_kb * 1024;
+      }
+
+      if (cd.mattrs.frame_arena_size < min_frame_arena_size) {
+        log_warn("frame_arena_kb in config.yaml is too small. Using {} KiB",
+                 min_frame_arena_size / 1024);
+        cd.mattrs.frame_arena_size = min_frame_arena_size;
+      }
+    }
+
+    // The executor section is optional
+    if (tree.rootref().has_child("executor")) {
+      const auto executor{tree["executor"]};
+
+      cd.eattrs.worker_count = strtoull(executor["workers"].val().data(), nullptr, 10);
+      cd.eattrs.physical_cores_only
+          = static_cast<bool>(atoi(executor["physical_cores_only"].val().data()));
+      cd.eattrs.main_thread_core = atoi(executor["main_thread_core"].val().data());
+      cd.eattrs.worker_cpus = parse_cpu_list(
+          {executor["worker_cpus"].val().data(), executor["worker_cpus"].val().size()});
+      cd.eattrs.pin_workers = static_cast<bool>(atoi(executor["pin_workers"].val().data()));
+      cd.eattrs.worker_priority = parse_priority(
+          {executor["worker_priority"].val().data(), executor["worker_priority"].val().size()});
+      cd.eattrs.normal_workers = strtoull(executor["normal_workers"].val().data(), nullptr, 10);
+      cd.eattrs.background_workers
+          = strtoull(executor["background_workers"].val().data(), nullptr, 10);
+      cd.eattrs.background_yield = atof(executor["background_yield_ms"].val().data()) / 1000.0;
+    }
 
     return cd;
   } catch (const std::exception &) {
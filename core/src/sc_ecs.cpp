@@ -0,0 +1,169 @@
+#include "sc_ecs.hpp"
+
+#include "sc_glm_includes.hpp"
+#include "sc_options.hpp"
+
+#include <algorithm>
+
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+auto surge::ecs::model_matrix(const transform &t) noexcept -> glm::mat4 {
+  auto model{glm::translate(glm::mat4{1.0f}, t.position)};
+  if (t.rotation != 0.0f) {
+    model = glm::rotate(model, t.rotation, glm::vec3{0.0f, 0.0f, 1.0f});
+  }
+  return glm::scale(model, glm::vec3{t.scale, 1.0f});
+}
+
+void surge::ecs::scheduler::add(u32 stage, std::string_view name, system s) {
+  systems.push_back(entry{stage, string{name}, std::move(s)});
+  graph_dirty = true;
+}
+
+void surge::ecs::scheduler::clear() {
+  systems.clear();
+  graph.clear();
+  graph_dirty = true;
+}
+
+void surge::ecs::scheduler::build_graph() {
+  std::stable_sort(systems.begin(), systems.end(),
+                   [](const entry &a, const entry &b) { return a.stage < b.stage; });
+
+  graph.clear();
+
+  // One join task between consecutive stages instead of linking every pair of systems
+  tf::Task previous_join{};
+  bool has_previous{false};
+
+  for (usize first = 0; first < systems.size();) {
+    auto last{first};
+    while (last < systems.size() && systems[last].stage == systems[first].stage) {
+      last++;
+    }
+
+    auto join{graph.emplace([]() {})};
+
+    for (auto i = first; i < last; i++) {
+      auto task{graph.emplace([this, i]() {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+        ZoneScopedN("surge::ecs::scheduler::system");
+        ZoneText(systems[i].name.data(), systems[i].name.size());
+#endif
+        systems[i].fn(*current_reg, current_dt);
+      })};
+      task.name(std::string{systems[i].name});
+      task.precede(join);
+
+      if (has_previous) {
+        task.succeed(previous_join);
+      }
+    }
+
+    previous_join = join;
+    has_previous = true;
+    first = last;
+  }
+
+  graph_dirty = false;
+}
+
+void surge::ecs::scheduler::run(registry &reg, double dt) {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::ecs::scheduler::run");
+#endif
+
+  if (systems.empty()) {
+    return;
+  }
+
+  if (graph_dirty) {
+    build_graph();
+  }
+
+  current_reg = &reg;
+  current_dt = dt;
+  tasks::run_and_wait(graph);
+}
+
+void surge::ecs::feed_sprites(registry &reg, gl_atom::sprite_database::database sdb,
+                              usize grain) {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::ecs::feed_sprites");
+#endif
+
+  namespace sdb_ns = gl_atom::sprite_database;
+
+  auto &sprites{reg.raw().storage<sprite>()};
+  auto &transforms{reg.raw().storage<transform>()};
+
+  const auto count{sprites.size()};
+  if (count == 0) {
+    return;
+  }
+
+  const auto entities{sprites.data()};
+  const auto chunks{(count + grain - 1) / grain};
+
+  const auto drawn{[&](entity e) {
+    return e != entt::tombstone && transforms.contains(e) && sprites.get(e).visible;
+  }};
+
+  /*
+   * Two passes keep the output deterministic without any atomics: the first counts what each
+   * chunk will write, the second writes every chunk at its prefix sum offset.
+   */
+  vector<usize> offsets(chunks + 1, 0);
+
+  const auto count_chunk{[&](usize c) {
+    usize n{0};
+    for (auto i = c * grain; i < std::min(count, (c + 1) * grain); i++) {
+      n += drawn(entities[i]) ? 1 : 0;
+    }
+    offsets[c + 1] = n;
+  }};
+
+  tasks::parallel_for(0, chunks, 1, count_chunk);
+
+  for (usize c = 0; c < chunks; c++) {
+    offsets[c + 1] += offsets[c];
+  }
+
+  const auto range{sdb_ns::reserve(sdb, offsets[chunks])};
+
+  const auto write_chunk{[&](usize c) {
+    auto slot{offsets[c]};
+    for (auto i = c * grain; i < std::min(count, (c + 1) * grain) && slot < range.count; i++) {
+      const auto e{entities[i]};
+      if (!drawn(e)) {
+        continue;
+      }
+
+      const auto &s{sprites.get(e)};
+      sdb_ns::write(sdb, range.first + slot, s.texture_handle, model_matrix(transforms.get(e)),
+                    s.color_mod, s.view);
+      slot++;
+    }
+  }};
+
+  tasks::parallel_for(0, chunks, 1, write_chunk);
+}
+
+void surge::ecs::feed_text(registry &reg, gl_atom::text::text_buffer &buffer) {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::ecs::feed_text");
+#endif
+
+  for (auto [e, t, txt] : reg.view<transform, text>().each()) {
+    if (txt.cache != nullptr) {
+      buffer.push(t.position, t.scale, *txt.cache, txt.contents.view());
+    }
+  }
+}
\ No newline at end of file
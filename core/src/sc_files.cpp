@@ -1,6 +1,7 @@
 #include "sc_files.hpp"
 
 #include "sc_allocators.hpp"
+#include "sc_archive.hpp"
 #include "sc_logging.hpp"
 #include "sc_options.hpp"
 
@@ -10,13 +11,19 @@
 #  include <array>
 #  include <gsl/gsl-lite.hpp>
 #  include <io.h>
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
 #endif
 
 // clang-format off
 #define STB_IMAGE_IMPLEMENTATION
-#define STBI_MALLOC(sz)           surge::allocators::mimalloc::malloc(sz)
-#define STBI_REALLOC(p,newsz)     surge::allocators::mimalloc::realloc(p,newsz)
-#define STBI_FREE(p)              surge::allocators::mimalloc::free(p)
+#define SURGE_STBI_TAG            surge::allocators::accounting::tag::textures
+#define STBI_MALLOC(sz)           surge::allocators::mimalloc::malloc(sz, SURGE_STBI_TAG)
+#define STBI_REALLOC(p,newsz)     surge::allocators::mimalloc::realloc(p, newsz, SURGE_STBI_TAG)
+#define STBI_FREE(p)              surge::allocators::mimalloc::free(p, SURGE_STBI_TAG)
 #include <stb_image.h>
 
 #include <OpenEXR/ImfRgbaFile.h>
@@ -24,9 +31,13 @@
 #include <Imath/ImathBox.h>
 // clang-format on
 
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <gsl/gsl-lite.hpp>
+#include <memory>
+#include <optional>
+#include <utility>
 
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
@@ -55,9 +66,14 @@ auto surge::files::validate_path(const char *path) -> bool {
   }
 }
 
+// Largest request passed to a single read call. Linux transfers at most 0x7ffff000 bytes per call
+static constexpr surge::usize max_read_chunk{1u << 30};
+
 #ifdef SURGE_SYSTEM_Windows
 
-auto os_open_read(const char *path, void *buffer, unsigned int file_size) -> bool {
+// Direct reads are not implemented on Windows, the mode is ignored
+auto os_open_read(const char *path, void *buffer, surge::usize size, surge::files::io_mode)
+    -> bool {
   std::array<char, 256> error_msg_buff{};
   error_msg_buff.fill('\0');
 
@@ -68,30 +84,143 @@ auto os_open_read(const char *path, void *buffer, unsigned int file_size) -> boo
     return false;
   }
 
-  if (_read(fd, buffer, file_size) == -1) {
-    strerror_s(error_msg_buff.data(), error_msg_buff.size(), errno);
-    log_error("Uanable to read the file {}: {}", path, error_msg_buff.data());
-    _close(fd);
-    return false;
+  // _read takes 32 bit sizes, so large files are read in chunks
+  auto dst{static_cast<std::byte *>(buffer)};
+  surge::usize done{0};
+  while (done < size) {
+    const auto chunk{static_cast<unsigned int>(std::min(size - done, max_read_chunk))};
+    const auto r{_read(fd, dst + done, chunk)};
+
+    if (r == -1) {
+      strerror_s(error_msg_buff.data(), error_msg_buff.size(), errno);
+      log_error("Uanable to read the file {}: {}", path, error_msg_buff.data());
+      _close(fd);
+      return false;
+    }
+
+    if (r == 0) {
+      break;
+    }
+
+    done += static_cast<surge::usize>(r);
   }
 
   _close(fd);
 
+  if (done != size) {
+    log_error("Unable to read the file {}: got {} of {} bytes", path, done, size);
+    return false;
+  }
+
   return true;
 }
 
 #else
 
-auto os_open_read(const char *path, void *buffer, unsigned int file_size) -> bool {
+// O_DIRECT transfers must be aligned to the device block size. Data goes through a bounce buffer
+static constexpr surge::usize direct_alignment{4096};
+static constexpr surge::usize direct_chunk{8 * 1024 * 1024};
+
+/*
+ * Reads size bytes at offset, looping over short reads and retrying interrupted ones. Returns the
+ * number of bytes read, which is less than size only when the end of the file is reached.
+ */
+static auto pread_full(int fd, std::byte *buffer, surge::usize size, surge::usize offset)
+    -> std::optional<surge::usize> {
+  surge::usize done{0};
+  while (done < size) {
+    const auto chunk{std::min(size - done, max_read_chunk)};
+    const auto r{pread(fd, buffer + done, chunk, static_cast<off_t>(offset + done))};
+
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return {};
+    }
+
+    if (r == 0) {
+      break;
+    }
+
+    done += static_cast<surge::usize>(r);
+  }
+  return done;
+}
+
+/*
+ * Reads the first size bytes of a file opened with O_DIRECT. Page cache bypassing reads must start
+ * at aligned offsets into aligned memory, so the file is read in aligned chunks into a bounce
+ * buffer and copied out. Every read starts at the block holding the first byte still missing, so a
+ * short read is resumed by reading its last partial block again. The last chunk may extend past
+ * the end of the file, where the kernel returns a short read.
+ */
+static auto pread_direct(int fd, std::byte *buffer, surge::usize size)
+    -> std::optional<surge::usize> {
+  using namespace surge::allocators;
+
+  const auto bounce_size{
+      std::min(direct_chunk, (size + direct_alignment - 1) / direct_alignment * direct_alignment)};
+  auto bounce{static_cast<std::byte *>(mimalloc::aligned_alloc(bounce_size, direct_alignment))};
+  if (bounce == nullptr) {
+    errno = ENOMEM;
+    return {};
+  }
+
+  surge::usize done{0};
+  while (done < size) {
+    const auto offset{done / direct_alignment * direct_alignment};
+    const auto r{pread(fd, bounce, bounce_size, static_cast<off_t>(offset))};
+
+    if (r == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      mimalloc::aligned_free(bounce, direct_alignment);
+      return {};
+    }
+
+    // Nothing past what was already copied means the end of the file
+    const auto end{std::min(offset + static_cast<surge::usize>(r), size)};
+    if (end <= done) {
+      break;
+    }
+
+    std::memcpy(buffer + done, bounce + (done - offset), end - done);
+    done = end;
+  }
+
+  mimalloc::aligned_free(bounce, direct_alignment);
+  return done;
+}
+
+auto os_open_read(const char *path, void *buffer, surge::usize size, surge::files::io_mode mode)
+    -> bool {
+  auto direct{mode == surge::files::io_mode::direct};
+
+#ifdef O_DIRECT
   // NOLINTNEXTLINE
-  int fd = open(path, O_RDONLY);
+  int fd = open(path, direct ? O_RDONLY | O_DIRECT : O_RDONLY);
+
+  if (fd == -1 && direct && errno == EINVAL) {
+    log_warn("The file system of {} does not support direct reads. Using cached reads", path);
+    direct = false;
+    fd = open(path, O_RDONLY); // NOLINT
+  }
+#else
+  direct = false;
+  int fd = open(path, O_RDONLY); // NOLINT
+#endif
 
   if (fd == -1) {
     log_error("Error while oppening file: {}", std::strerror(errno));
     return false;
   }
 
-  if (read(fd, buffer, file_size) == -1) {
+  const auto dst{static_cast<std::byte *>(buffer)};
+  const auto done{direct ? pread_direct(fd, dst, size) : pread_full(fd, dst, size, 0)};
+
+  if (!done) {
     log_error("Uanable to read the file {}: {}", path, std::strerror(errno));
     close(fd);
     return false;
@@ -99,12 +228,17 @@ auto os_open_read(const char *path, void *buffer, unsigned int file_size) -> boo
 
   close(fd);
 
+  if (*done != size) {
+    log_error("Unable to read the file {}: got {} of {} bytes", path, *done, size);
+    return false;
+  }
+
   return true;
 }
 
 #endif
 
-auto surge::files::load_file(const char *path, bool append_null_byte) -> file {
+auto surge::files::load_file(const char *path, bool append_null_byte, io_mode mode) -> file {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::files::load_file");
@@ -114,20 +248,20 @@ auto surge::files::load_file(const char *path, bool append_null_byte) -> file {
     log_info("Loading raw data for file {}. Appending null byte: {}", path,
              append_null_byte ? "true" : "false");
 
+    if (const auto m{find_mounted(path)}) {
+      return m->pack->read(*m->entry, append_null_byte);
+    }
+
     if (!validate_path(path)) {
       return tl::unexpected(error::invalid_path);
     }
 
-    auto file_size{static_cast<unsigned int>(std::filesystem::file_size(path))};
-    if (append_null_byte) {
-      file_size += 1;
-    }
+    const auto file_size{static_cast<usize>(std::filesystem::file_size(path))};
 
-    file_data_t buffer(file_size);
-    buffer.reserve(file_size);
-    std::fill(buffer.begin(), buffer.end(), std::byte{0});
+    // Value initialized, so the appended byte is already null
+    file_data_t buffer(append_null_byte ? file_size + 1 : file_size);
 
-    if (os_open_read(path, buffer.data(), file_size)) {
+    if (os_open_read(path, buffer.data(), file_size, mode)) {
       return buffer;
     } else {
       return tl::unexpected(error::read_error);
@@ -139,28 +273,169 @@ auto surge::files::load_file(const char *path, bool append_null_byte) -> file {
   }
 }
 
-auto surge::files::load_image(const char *p, bool flip) -> image {
+// Address and size of a file mapping
+using os_view = tl::expected<std::pair<const std::byte *, surge::usize>, surge::error>;
+
+#ifdef SURGE_SYSTEM_Windows
+
+static void unmap(const std::byte *p, surge::usize) {
+  if (p != nullptr) {
+    UnmapViewOfFile(p);
+  }
+}
+
+static auto os_map_read(const char *path) -> os_view {
+  const auto file{CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+  if (file == INVALID_HANDLE_VALUE) {
+    log_error("Error while oppening file {}: error code {}", path, GetLastError());
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  LARGE_INTEGER size{};
+  if (GetFileSizeEx(file, &size) == 0) {
+    log_error("Unable to get the size of file {}: error code {}", path, GetLastError());
+    CloseHandle(file);
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return std::pair<const std::byte *, surge::usize>{nullptr, 0};
+  }
+
+  // The view keeps both the mapping object and the file open
+  const auto mapping_object{CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+  CloseHandle(file);
+
+  if (mapping_object == nullptr) {
+    log_error("Unable to map file {}: error code {}", path, GetLastError());
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  const auto view{MapViewOfFile(mapping_object, FILE_MAP_READ, 0, 0, 0)};
+  CloseHandle(mapping_object);
+
+  if (view == nullptr) {
+    log_error("Unable to map file {}: error code {}", path, GetLastError());
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  return std::pair{static_cast<const std::byte *>(view), static_cast<surge::usize>(size.QuadPart)};
+}
+
+#else
+
+static void unmap(const std::byte *p, surge::usize size) {
+  if (p != nullptr) {
+    munmap(const_cast<std::byte *>(p), size); // NOLINT
+  }
+}
+
+static auto os_map_read(const char *path) -> os_view {
+  // NOLINTNEXTLINE
+  const int fd = open(path, O_RDONLY);
+
+  if (fd == -1) {
+    log_error("Error while oppening file {}: {}", path, std::strerror(errno));
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) == -1) {
+    log_error("Unable to get the size of file {}: {}", path, std::strerror(errno));
+    close(fd);
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  const auto size{static_cast<surge::usize>(st.st_size)};
+  if (size == 0) {
+    close(fd);
+    return std::pair<const std::byte *, surge::usize>{nullptr, 0};
+  }
+
+  // The mapping keeps the file open
+  auto p{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+  close(fd);
+
+  if (p == MAP_FAILED) {
+    log_error("Unable to map file {}: {}", path, std::strerror(errno));
+    return tl::unexpected(surge::error::read_error);
+  }
+
+  // Hints only, a failure here does not affect the mapping
+  madvise(p, size, MADV_SEQUENTIAL);
+  madvise(p, size, MADV_WILLNEED);
+
+  return std::pair{static_cast<const std::byte *>(p), size};
+}
+
+#endif
+
+surge::files::mapped_file::mapped_file(const std::byte *p, usize size, bool borrowed_view) noexcept
+    : ptr{p}, len{size}, borrowed{borrowed_view} {}
+
+// Views into a buffer it owns, which moves along with it
+surge::files::mapped_file::mapped_file(file_data_t &&buffer) noexcept
+    : ptr{buffer.data()}, len{buffer.size()}, borrowed{true}, owned{std::move(buffer)} {}
+
+surge::files::mapped_file::~mapped_file() {
+  if (!borrowed) {
+    unmap(ptr, len);
+  }
+}
+
+surge::files::mapped_file::mapped_file(mapped_file &&other) noexcept
+    : ptr{std::exchange(other.ptr, nullptr)}, len{std::exchange(other.len, 0)},
+      borrowed{std::exchange(other.borrowed, false)}, owned{std::move(other.owned)} {}
+
+auto surge::files::mapped_file::operator=(mapped_file &&other) noexcept -> mapped_file & {
+  if (this != &other) {
+    if (!borrowed) {
+      unmap(ptr, len);
+    }
+    ptr = std::exchange(other.ptr, nullptr);
+    len = std::exchange(other.len, 0);
+    borrowed = std::exchange(other.borrowed, false);
+    owned = std::move(other.owned);
+  }
+  return *this;
+}
+
+auto surge::files::map_file(const char *path) -> mapping {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
-  ZoneScopedN("surge::files::load_image");
+  ZoneScopedN("surge::files::map_file");
 #endif
 
-  log_info("Loading image file {}", p);
+  log_info("Mapping file {}", path);
 
-  auto file{load_file(p, false)};
-  if (!file) {
-    log_error("Unable to load image file {}", p);
-    return tl::unexpected(surge::error::image_load_error);
+  if (const auto m{find_mounted(path)}) {
+    return m->pack->map(*m->entry);
+  }
+
+  if (!validate_path(path)) {
+    return tl::unexpected(error::invalid_path);
+  }
+
+  const auto view{os_map_read(path)};
+  if (!view) {
+    return tl::unexpected(view.error());
   }
 
+  return mapped_file{view->first, view->second, false};
+}
+
+auto surge::files::decode_image(const char *p, std::span<const std::byte> bytes, bool flip)
+    -> image {
   int iw{0}, ih{0}, channels_in_file{0};
 
   if (flip) {
     stbi_set_flip_vertically_on_load(static_cast<int>(true));
   }
 
-  auto pixels{stbi_load_from_memory(static_cast<stbi_uc *>(static_cast<void *>(file->data())),
-                                    gsl::narrow_cast<int>(file.value().size()), &iw, &ih,
+  auto pixels{stbi_load_from_memory(reinterpret_cast<const stbi_uc *>(bytes.data()), // NOLINT
+                                    gsl::narrow_cast<int>(bytes.size()), &iw, &ih,
                                     &channels_in_file, 0)};
 
   if (flip) {
@@ -175,6 +450,23 @@ auto surge::files::load_image(const char *p, bool flip) -> image {
   return image_data{iw, ih, channels_in_file, pixels, p};
 }
 
+auto surge::files::load_image(const char *p, bool flip) -> image {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+  ZoneScopedN("surge::files::load_image");
+#endif
+
+  log_info("Loading image file {}", p);
+
+  const auto file{map_file(p)};
+  if (!file) {
+    log_error("Unable to load image file {}", p);
+    return tl::unexpected(surge::error::image_load_error);
+  }
+
+  return decode_image(p, file->view(), flip);
+}
+
 auto surge::files::load_openEXR(const char *p) -> openEXR_image {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
@@ -195,8 +487,9 @@ auto surge::files::load_openEXR(const char *p) -> openEXR_image {
     Imath::Box2i win = in.dataWindow();
     Imath::V2i dim(win.max.x - win.min.x + 1, win.max.y - win.min.y + 1);
 
-    auto pixel_buffer{allocators::mimalloc::malloc(sizeof(Imf::Rgba) * static_cast<usize>(dim.x)
-                                                   * static_cast<usize>(dim.y))};
+    auto pixel_buffer{allocators::mimalloc::malloc(
+        sizeof(Imf::Rgba) * static_cast<usize>(dim.x) * static_cast<usize>(dim.y),
+        allocators::accounting::tag::textures)};
 
     int dx = win.min.x;
     int dy = win.min.y;
@@ -215,7 +508,7 @@ auto surge::files::load_openEXR(const char *p) -> openEXR_image {
 }
 
 void surge::files::free_openEXR(openEXR_image_data &data) {
-  allocators::mimalloc::free(data.pixels);
+  allocators::mimalloc::free(data.pixels, allocators::accounting::tag::textures);
 }
 
 void surge::files::free_image(image_data &image) { stbi_image_free(image.pixels); }
@@ -224,9 +517,28 @@ auto surge::files::load_image_task(const char *path, bool flip) -> img_future {
   // This option has to be set before the parallel tasks because STBI implements it as a global
   // variable
   stbi_set_flip_vertically_on_load(static_cast<int>(flip));
-  return tasks::executor::get().async([=]() { return load_image(path, false); });
+
+  log_info("Loading image file {}", path);
+
+  // Images in mounted packs are decoded straight from the pack mapping
+  if (find_mounted(path)) {
+    return tasks::async(tasks::priority::background, [=]() { return load_image(path, false); });
+  }
+
+  // Decoding starts on a background worker as soon as the file read completes
+  auto promise{std::make_shared<std::promise<image>>()};
+  auto future{promise->get_future()};
+  load_file_async(path, false, [=](file data) {
+    if (!data) {
+      log_error("Unable to load image file {}", path);
+      promise->set_value(tl::unexpected(surge::error::image_load_error));
+    } else {
+      promise->set_value(decode_image(path, *data, false));
+    }
+  });
+  return future;
 }
 
 void surge::files::free_image_task(image_data &image) {
-  tasks::executor::get().silent_async([=]() { stbi_image_free(image.pixels); });
+  tasks::silent_async(tasks::priority::background, [=]() { stbi_image_free(image.pixels); });
 }
\ No newline at end of file
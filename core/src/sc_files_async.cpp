@@ -0,0 +1,588 @@
+#include "sc_archive.hpp"
+#include "sc_files.hpp"
+#include "sc_logging.hpp"
+#include "sc_options.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#ifdef SURGE_SYSTEM_Linux
+#  include <atomic>
+#  include <cerrno>
+#  include <cstring>
+#  include <fcntl.h>
+#  include <linux/io_uring.h>
+#  include <mutex>
+#  include <sys/eventfd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/syscall.h>
+#  include <thread>
+#  include <unistd.h>
+#endif
+
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+#  include <tracy/Tracy.hpp>
+#endif
+
+using surge::u64;
+using surge::usize;
+using surge::files::file;
+using surge::files::file_callback;
+
+struct read_request {
+  surge::string path{};
+  bool append_null_byte{false};
+  file_callback on_complete{};
+  surge::tasks::priority p{surge::tasks::priority::background};
+};
+
+// Hands a finished read to its callback on the executor
+static void complete(read_request *r, file data) {
+  surge::tasks::silent_async(r->p, [r, data = std::move(data)]() mutable {
+    r->on_complete(std::move(data));
+    delete r; // NOLINT
+  });
+}
+
+#ifdef SURGE_SYSTEM_Linux
+
+// Submission queue entries. Also the most reads the IO thread keeps in flight
+static constexpr unsigned int queue_depth{128};
+
+// Files are read in chunks of this size, so large files keep the device queue busy
+static constexpr usize read_chunk{1024 * 1024};
+
+struct uring_read;
+
+struct uring_chunk {
+  uring_read *owner{nullptr};
+  usize offset{0};
+  usize length{0};
+};
+
+/*
+ * A file being read. The chunks vector is sized once, so chunk addresses are stable and serve as
+ * the user data of their submissions.
+ */
+struct uring_read {
+  read_request *request{nullptr};
+  int fd{-1};
+  surge::files::file_data_t data{};
+  surge::vector<uring_chunk> chunks{};
+  usize pending{0};
+  usize in_flight{0}; // Chunks submitted to the kernel and not completed yet
+  usize index{0};     // Position in the IO thread's list of open reads
+  bool failed{false};
+};
+
+/*
+ * The io_uring instance and the thread that drives it, set up with raw syscalls so the engine does
+ * not depend on liburing. Other threads queue requests and wake the IO thread through an eventfd,
+ * which the IO thread always keeps a read pending on. The IO thread opens the files, submits their
+ * chunks, reaps completions and resubmits short reads. If the ring stops accepting submissions,
+ * every read is failed and later requests go to the blocking fallback.
+ */
+class uring_service {
+public:
+  uring_service() {
+    // Completions are handed to the executors, which must outlive this service
+    surge::tasks::executor::get();
+    surge::tasks::executor::get(surge::tasks::priority::normal);
+    surge::tasks::executor::get(surge::tasks::priority::background);
+
+    if (!setup()) {
+      teardown();
+      return;
+    }
+
+    io_thread = std::thread{[this] { run(); }};
+    log_info("Asynchronous file IO using io_uring with {} entries", sq_entries);
+  }
+
+  ~uring_service() {
+    if (!io_thread.joinable()) {
+      return;
+    }
+
+    {
+      const std::lock_guard lock{incoming_mutex};
+      stopping = true;
+    }
+    wake();
+    io_thread.join();
+    teardown();
+
+    for (auto read : abandoned) {
+      delete read; // NOLINT
+    }
+  }
+
+  uring_service(const uring_service &) = delete;
+  auto operator=(const uring_service &) -> uring_service & = delete;
+
+  [[nodiscard]] auto available() const noexcept -> bool {
+    return io_thread.joinable() && !broken.load(std::memory_order_acquire);
+  }
+
+  // Returns false when the ring broke down, leaving the requests to the caller
+  auto submit(std::span<read_request *const> requests) -> bool {
+    {
+      const std::lock_guard lock{incoming_mutex};
+      if (broken.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      incoming.insert(incoming.end(), requests.begin(), requests.end());
+    }
+    wake();
+    return true;
+  }
+
+private:
+  int ring_fd{-1};
+  int event_fd{-1};
+  u64 event_value{0};
+
+  void *sq_ptr{nullptr};
+  usize sq_size{0};
+  void *cq_ptr{nullptr};
+  usize cq_size{0};
+  io_uring_sqe *sqes{nullptr};
+  usize sqes_size{0};
+
+  unsigned int *sq_head{nullptr};
+  unsigned int *sq_tail{nullptr};
+  unsigned int *sq_mask{nullptr};
+  unsigned int *sq_array{nullptr};
+  unsigned int sq_entries{0};
+
+  unsigned int *cq_head{nullptr};
+  unsigned int *cq_tail{nullptr};
+  unsigned int *cq_mask{nullptr};
+  io_uring_cqe *cqes{nullptr};
+
+  std::thread io_thread{};
+  std::mutex incoming_mutex{};
+  surge::vector<read_request *> incoming{};
+  bool stopping{false};
+  std::atomic<bool> broken{false}; // Set under incoming_mutex
+
+  // Owned by the IO thread
+  surge::vector<uring_read *> reads{};
+  surge::deque<uring_chunk *> ready{};
+  unsigned int to_submit{0};
+  usize reads_in_flight{0};
+
+  // Failed reads the kernel may still write to, freed once the ring is closed
+  surge::vector<uring_read *> abandoned{};
+
+  auto setup() -> bool {
+    io_uring_params params{};
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd < 0) {
+      log_warn("io_uring is not available ({}). Using blocking reads", std::strerror(errno));
+      return false;
+    }
+
+    // IORING_OP_READ arrived along with this feature, in Linux 5.6
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      log_warn("The kernel io_uring lacks plain reads. Using blocking reads");
+      return false;
+    }
+
+    sq_entries = params.sq_entries;
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    const bool single_mmap{(params.features & IORING_FEAT_SINGLE_MMAP) != 0};
+    if (single_mmap) {
+      sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+
+    sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+      sq_ptr = nullptr;
+      log_warn("Unable to map the io_uring submission queue. Using blocking reads");
+      return false;
+    }
+
+    if (single_mmap) {
+      cq_ptr = sq_ptr;
+    } else {
+      cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                    IORING_OFF_CQ_RING);
+      if (cq_ptr == MAP_FAILED) {
+        cq_ptr = nullptr;
+        log_warn("Unable to map the io_uring completion queue. Using blocking reads");
+        return false;
+      }
+    }
+
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes_ptr{mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ring_fd, IORING_OFF_SQES)};
+    if (sqes_ptr == MAP_FAILED) {
+      log_warn("Unable to map the io_uring submission entries. Using blocking reads");
+      return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    const auto sq_base{static_cast<char *>(sq_ptr)};
+    sq_head = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.head);      // NOLINT
+    sq_tail = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.tail);      // NOLINT
+    sq_mask = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.ring_mask); // NOLINT
+    sq_array = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.array);    // NOLINT
+
+    const auto cq_base{static_cast<char *>(cq_ptr)};
+    cq_head = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.head);      // NOLINT
+    cq_tail = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.tail);      // NOLINT
+    cq_mask = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.ring_mask); // NOLINT
+    cqes = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);         // NOLINT
+
+    event_fd = eventfd(0, EFD_CLOEXEC);
+    if (event_fd < 0) {
+      log_warn("Unable to create the IO wake up event ({}). Using blocking reads",
+               std::strerror(errno));
+      return false;
+    }
+
+    return true;
+  }
+
+  void teardown() {
+    if (sqes != nullptr) {
+      munmap(sqes, sqes_size);
+      sqes = nullptr;
+    }
+    if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_size);
+    }
+    cq_ptr = nullptr;
+    if (sq_ptr != nullptr) {
+      munmap(sq_ptr, sq_size);
+      sq_ptr = nullptr;
+    }
+    if (event_fd >= 0) {
+      close(event_fd);
+      event_fd = -1;
+    }
+    if (ring_fd >= 0) {
+      close(ring_fd);
+      ring_fd = -1;
+    }
+  }
+
+  void wake() {
+    const u64 one{1};
+    while (write(event_fd, &one, sizeof(one)) == -1 && errno == EINTR) {
+    }
+  }
+
+  // Fills the next submission entry. The caller makes sure the queue has room
+  void push_read(int fd, void *buffer, usize length, usize offset, u64 user_data) {
+    const auto tail{std::atomic_ref{*sq_tail}.load(std::memory_order_relaxed)};
+    const auto index{tail & *sq_mask};
+
+    auto &sqe{sqes[index]};
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = reinterpret_cast<u64>(buffer); // NOLINT
+    sqe.len = static_cast<unsigned int>(length);
+    sqe.user_data = user_data;
+
+    sq_array[index] = index;
+    std::atomic_ref{*sq_tail}.store(tail + 1, std::memory_order_release);
+    to_submit++;
+  }
+
+  // The wake up read is the only submission with a null user data
+  void arm_wake_up() { push_read(event_fd, &event_value, sizeof(event_value), 0, 0); }
+
+  void start_read(read_request *r) {
+    // NOLINTNEXTLINE
+    const int fd = open(r->path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+
+    if (fd == -1 || fstat(fd, &st) == -1) {
+      log_error("Error while oppening file {}: {}", r->path.c_str(), std::strerror(errno));
+      if (fd != -1) {
+        close(fd);
+      }
+      complete(r, tl::unexpected(surge::error::read_error));
+      return;
+    }
+
+    const auto size{static_cast<usize>(st.st_size)};
+    auto read{new uring_read{}}; // NOLINT
+    read->request = r;
+    read->fd = fd;
+    read->index = reads.size();
+    reads.push_back(read);
+    read->data = surge::files::file_data_t(r->append_null_byte ? size + 1 : size);
+
+    const auto chunk_count{(size + read_chunk - 1) / read_chunk};
+    read->chunks.resize(chunk_count);
+    read->pending = chunk_count;
+
+    for (usize i = 0; i < chunk_count; i++) {
+      auto &c{read->chunks[i]};
+      c.owner = read;
+      c.offset = i * read_chunk;
+      c.length = std::min(read_chunk, size - c.offset);
+      ready.push_back(&c);
+    }
+
+    if (chunk_count == 0) {
+      finish(read);
+    }
+  }
+
+  void forget(uring_read *read) {
+    reads[read->index] = reads.back();
+    reads[read->index]->index = read->index;
+    reads.pop_back();
+  }
+
+  void finish(uring_read *read) {
+    forget(read);
+    close(read->fd);
+
+    if (read->failed) {
+      complete(read->request, tl::unexpected(surge::error::read_error));
+    } else {
+      complete(read->request, std::move(read->data));
+    }
+
+    delete read; // NOLINT
+  }
+
+  void on_chunk(uring_chunk *c, int res) {
+    auto read{c->owner};
+
+    if (res == -EINTR || res == -EAGAIN) {
+      ready.push_back(c);
+      return;
+    }
+
+    if (res <= 0) {
+      if (!read->failed) {
+        log_error("Unable to read the file {}: {}", read->request->path.c_str(),
+                  res == 0 ? "unexpected end of file" : std::strerror(-res));
+      }
+      read->failed = true;
+    } else if (static_cast<usize>(res) < c->length) {
+      // Short read. Submit the rest of the chunk again
+      c->offset += static_cast<usize>(res);
+      c->length -= static_cast<usize>(res);
+      ready.push_back(c);
+      return;
+    }
+
+    read->pending--;
+    if (read->pending == 0) {
+      finish(read);
+    }
+  }
+
+  // Fails queued and open reads after io_uring_enter failed for good
+  void fail_over(int err) {
+    log_error("io_uring_enter failed: {}. Using blocking reads", std::strerror(err));
+
+    surge::vector<read_request *> requests{};
+    {
+      const std::lock_guard lock{incoming_mutex};
+      broken.store(true, std::memory_order_release);
+      requests.swap(incoming);
+    }
+
+    for (auto r : requests) {
+      complete(r, tl::unexpected(surge::error::read_error));
+    }
+
+    ready.clear();
+
+    for (auto read : reads) {
+      close(read->fd);
+      complete(read->request, tl::unexpected(surge::error::read_error));
+
+      if (read->in_flight == 0) {
+        delete read; // NOLINT
+      } else {
+        abandoned.push_back(read);
+      }
+    }
+
+    reads.clear();
+  }
+
+  void run() {
+    arm_wake_up();
+
+    bool wake_up_armed{true};
+
+    while (true) {
+#if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
+    && defined(SURGE_ENABLE_TRACY)
+      ZoneScopedN("surge::files::io_uring");
+#endif
+
+      if (!wake_up_armed) {
+        arm_wake_up();
+        wake_up_armed = true;
+      }
+
+      // Open newly queued files
+      surge::vector<read_request *> requests{};
+      bool stop_requested{false};
+      {
+        const std::lock_guard lock{incoming_mutex};
+        requests.swap(incoming);
+        stop_requested = stopping;
+      }
+
+      for (auto r : requests) {
+        start_read(r);
+      }
+
+      // Queue as many chunks as there is room for. One entry stays reserved for the wake up read
+      while (!ready.empty() && reads_in_flight + 1 < sq_entries) {
+        auto c{ready.front()};
+        ready.pop_front();
+        push_read(c->owner->fd, c->owner->data.data() + c->offset, c->length, c->offset,
+                  reinterpret_cast<u64>(c)); // NOLINT
+        c->owner->in_flight++;
+        reads_in_flight++;
+      }
+
+      // Reads already submitted are completed before stopping
+      if (stop_requested && reads_in_flight == 0 && ready.empty()) {
+        break;
+      }
+
+      const auto entered{syscall(__NR_io_uring_enter, ring_fd, to_submit, 1,
+                                 IORING_ENTER_GETEVENTS, nullptr, 0)};
+
+      // Interrupted or busy calls are retried, other errors will not go away
+      int fatal_error{0};
+      if (entered < 0) {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+          fatal_error = errno;
+        }
+      } else {
+        to_submit -= static_cast<unsigned int>(entered);
+      }
+
+      auto head{std::atomic_ref{*cq_head}.load(std::memory_order_relaxed)};
+      const auto tail{std::atomic_ref{*cq_tail}.load(std::memory_order_acquire)};
+
+      for (; head != tail; head++) {
+        const auto &cqe{cqes[head & *cq_mask]};
+
+        if (cqe.user_data == 0) {
+          wake_up_armed = false;
+        } else {
+          const auto c{reinterpret_cast<uring_chunk *>(cqe.user_data)}; // NOLINT
+          c->owner->in_flight--;
+          reads_in_flight--;
+          on_chunk(c, cqe.res);
+        }
+      }
+
+      std::atomic_ref{*cq_head}.store(head, std::memory_order_release);
+
+      if (fatal_error != 0) {
+        fail_over(fatal_error);
+        break;
+      }
+    }
+  }
+};
+
+static auto uring() -> uring_service & {
+  static uring_service s{};
+  return s;
+}
+
+#endif
+
+auto surge::files::get_io_backend() -> io_backend {
+#ifdef SURGE_SYSTEM_Linux
+  if (uring().available()) {
+    return io_backend::io_uring;
+  }
+#endif
+  return io_backend::blocking;
+}
+
+static void submit(std::span<read_request *const> requests) {
+  surge::vector<read_request *> from_disk{};
+  from_disk.reserve(requests.size());
+
+  // Entries of mounted packs are already mapped, only the copy is left
+  for (auto r : requests) {
+    if (const auto m{surge::files::find_mounted(r->path)}) {
+      surge::tasks::silent_async(r->p, [r, m = *m]() {
+        r->on_complete(m.pack->read(*m.entry, r->append_null_byte));
+        delete r; // NOLINT
+      });
+    } else {
+      from_disk.push_back(r);
+    }
+  }
+
+  if (from_disk.empty()) {
+    return;
+  }
+
+#ifdef SURGE_SYSTEM_Linux
+  if (uring().available() && uring().submit(from_disk)) {
+    return;
+  }
+#endif
+
+  for (auto r : from_disk) {
+    surge::tasks::silent_async(r->p, [r]() {
+      r->on_complete(surge::files::load_file(r->path.c_str(), r->append_null_byte));
+      delete r; // NOLINT
+    });
+  }
+}
+
+void surge::files::load_file_async(const char *path, bool append_null_byte,
+                                   file_callback on_complete, tasks::priority p) {
+  // Requests are freed by whichever thread completes them, so they live on the engine heap
+  const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+  read_request *const r{
+      new read_request{string{path}, append_null_byte, std::move(on_complete), p}}; // NOLINT
+  submit({&r, 1});
+}
+
+void surge::files::load_files_async(std::span<const char *const> paths, bool append_null_byte,
+                                    batch_callback on_complete, tasks::priority p) {
+  const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+
+  const auto shared_callback{std::make_shared<batch_callback>(std::move(on_complete))};
+
+  vector<read_request *> requests{};
+  requests.reserve(paths.size());
+  for (usize i = 0; i < paths.size(); i++) {
+    requests.push_back(new read_request{ // NOLINT
+        string{paths[i]}, append_null_byte,
+        [shared_callback, i](file data) { (*shared_callback)(i, std::move(data)); }, p});
+  }
+
+  submit(requests);
+}
+
+auto surge::files::load_file_task(const char *path, bool append_null_byte, tasks::priority p)
+    -> file_future {
+  auto promise{std::make_shared<std::promise<file>>()};
+  auto future{promise->get_future()};
+  load_file_async(
+      path, append_null_byte, [promise](file data) { promise->set_value(std::move(data)); }, p);
+  return future;
+}
\ No newline at end of file
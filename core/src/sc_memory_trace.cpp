@@ -0,0 +1,207 @@
+#include "sc_memory_trace.hpp"
+
+#include "sc_logging.hpp"
+#include "sc_options.hpp"
+
+#ifdef SURGE_DEBUG_MEMORY
+
+#  include <array>
+#  include <atomic>
+#  include <chrono>
+#  include <cstdint>
+#  include <cstdio>
+
+// Number of records the ring buffer can hold between two flushes. Must be a power of 2
+static constexpr surge::usize ring_capacity{1 << 18};
+static constexpr surge::u64 ring_mask{ring_capacity - 1};
+
+// Number of records written to the file at once
+static constexpr surge::usize flush_batch_size{1024};
+
+/*
+ * Each slot is a small seqlock. A writer that claimed event i marks the slot with 2i + 1 while it
+ * writes and publishes it with 2i + 2, which lets the reader tell slots that are still being
+ * written from slots that were overwritten by a writer that lapped the ring.
+ */
+struct ring_slot {
+  std::atomic<surge::u64> sequence{0};
+  std::atomic<surge::u64> timestamp{0};
+  std::atomic<surge::u64> address{0};
+  std::atomic<surge::u64> size{0};
+  std::atomic<surge::u64> info{0}; // thread | operation << 32 | tag << 40
+};
+
+static std::array<ring_slot, ring_capacity> ring{};
+static std::atomic<surge::u64> ring_head{0};
+static std::atomic<bool> recording{false};
+
+// Only touched by the thread that flushes
+static surge::u64 ring_tail{0};
+static std::FILE *trace_file{nullptr};
+static std::chrono::steady_clock::time_point trace_epoch{};
+
+static thread_local const auto trace_thread_id{static_cast<surge::u32>(SURGE_TID_FUNCTION)};
+
+// Closes the trace if the program exits without calling stop()
+struct trace_guard {
+  ~trace_guard() { surge::allocators::trace::stop(); }
+};
+
+static trace_guard guard{};
+
+static auto now() noexcept -> surge::u64 {
+  const auto elapsed{std::chrono::steady_clock::now() - trace_epoch};
+  return static_cast<surge::u64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void surge::allocators::trace::record_event(op operation, accounting::tag t, const void *address,
+                                            usize size) noexcept {
+  if (!recording.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  const auto index{ring_head.fetch_add(1, std::memory_order_relaxed)};
+  auto &slot{ring[index & ring_mask]};
+
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.timestamp.store(now(), std::memory_order_relaxed);
+  slot.address.store(reinterpret_cast<std::uintptr_t>(address), std::memory_order_relaxed);
+  slot.size.store(size, std::memory_order_relaxed);
+  slot.info.store(static_cast<u64>(trace_thread_id) | (static_cast<u64>(operation) << 32)
+                      | (static_cast<u64>(t) << 40),
+                  std::memory_order_relaxed);
+
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+void surge::allocators::trace::flush() noexcept {
+  if (trace_file == nullptr) {
+    return;
+  }
+
+  std::array<record, flush_batch_size> batch{};
+  usize batch_count{0};
+  u64 dropped{0};
+
+  const auto write_batch{[&]() {
+    std::fwrite(batch.data(), sizeof(record), batch_count, trace_file);
+    batch_count = 0;
+  }};
+
+  const auto head{ring_head.load(std::memory_order_acquire)};
+
+  // Events that were overwritten before we could read them
+  if (head - ring_tail > ring_capacity) {
+    dropped += head - ring_capacity - ring_tail;
+    ring_tail = head - ring_capacity;
+  }
+
+  while (ring_tail < head) {
+    auto &slot{ring[ring_tail & ring_mask]};
+    const auto expected{2 * ring_tail + 2};
+    const auto sequence{slot.sequence.load(std::memory_order_acquire)};
+
+    // The writer did not publish this event yet. Pick it up on the next flush
+    if (sequence < expected) {
+      break;
+    }
+
+    if (sequence == expected) {
+      record r{};
+      r.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+      r.address = slot.address.load(std::memory_order_relaxed);
+      r.size = slot.size.load(std::memory_order_relaxed);
+
+      const auto info{slot.info.load(std::memory_order_relaxed)};
+      r.thread = static_cast<u32>(info & 0xFFFFFFFF);
+      r.operation = static_cast<op>((info >> 32) & 0xFF);
+      r.tag = static_cast<accounting::tag>((info >> 40) & 0xFF);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+        batch[batch_count++] = r;
+        if (batch_count == flush_batch_size) {
+          write_batch();
+        }
+      } else {
+        dropped++;
+      }
+    } else {
+      dropped++;
+    }
+
+    ring_tail++;
+  }
+
+  if (dropped != 0) {
+    if (batch_count == flush_batch_size) {
+      write_batch();
+    }
+
+    record r{};
+    r.timestamp = now();
+    r.size = dropped;
+    r.operation = op::dropped;
+    batch[batch_count++] = r;
+  }
+
+  write_batch();
+}
+
+auto surge::allocators::trace::start(const char *path) noexcept -> std::optional<error> {
+  if (trace_file != nullptr) {
+    log_warn("Memory trace already started");
+    return {};
+  }
+
+  log_info("Recording memory trace to {}", path);
+
+  // NOLINTNEXTLINE
+  trace_file = std::fopen(path, "wb");
+
+  if (trace_file == nullptr) {
+    log_error("Unable to open memory trace file {}", path);
+    return error::memory_trace_open;
+  }
+
+  const file_header header{};
+  std::fwrite(&header, sizeof(file_header), 1, trace_file);
+
+  trace_epoch = std::chrono::steady_clock::now();
+  ring_tail = ring_head.load(std::memory_order_acquire);
+  recording.store(true, std::memory_order_release);
+
+  return {};
+}
+
+void surge::allocators::trace::stop() noexcept {
+  if (trace_file == nullptr) {
+    return;
+  }
+
+  recording.store(false, std::memory_order_release);
+  flush();
+
+  std::fclose(trace_file);
+  trace_file = nullptr;
+
+  log_info("Memory trace closed");
+}
+
+#else
+
+// Without SURGE_DEBUG_MEMORY nothing is recorded, and the ring buffer is not linked in
+
+auto surge::allocators::trace::start(const char *) noexcept -> std::optional<error> { return {}; }
+
+void surge::allocators::trace::flush() noexcept {}
+
+void surge::allocators::trace::stop() noexcept {}
+
+void surge::allocators::trace::record_event(op, accounting::tag, const void *, usize) noexcept {}
+
+#endif
\ No newline at end of file
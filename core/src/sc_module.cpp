@@ -6,6 +6,43 @@
 #include <gsl/gsl-lite.hpp>
 #include <optional>
 
+// Heaps of the loaded modules. Only used from the main thread
+static surge::hash_map<surge::module::handle_t, surge::allocators::mimalloc::heap_t *>
+    module_heaps{};
+
+static void create_module_heap(surge::module::handle_t module) noexcept {
+  using namespace surge::allocators;
+
+  auto heap{mimalloc::heap_new()};
+  if (heap == nullptr) {
+    log_warn("Unable to create a heap for module {}. It will use the global heap",
+             static_cast<void *>(module));
+    return;
+  }
+
+  const mimalloc::heap_scope engine_heap{mimalloc::heap_get_backing()};
+  module_heaps[module] = heap;
+}
+
+static void destroy_module_heap(surge::module::handle_t module) noexcept {
+  using namespace surge::allocators;
+
+  const auto it{module_heaps.find(module)};
+  if (it == module_heaps.end()) {
+    return;
+  }
+
+  const auto leaked_bytes{mimalloc::heap_used_bytes(it->second)};
+  if (leaked_bytes != 0) {
+    log_error("Module {} left {} B allocated in its heap. Engine objects it did not destroy in "
+              "on_unload are released with them and must not be used again",
+              static_cast<void *>(module), leaked_bytes);
+  }
+
+  mimalloc::heap_destroy(it->second);
+  module_heaps.erase(it);
+}
+
 #ifdef SURGE_SYSTEM_Windows
 
 auto surge::module::get_name(handle_t module,
@@ -47,6 +84,7 @@ auto surge::module::load(const char *path) noexcept -> tl::expected<handle_t, er
     return tl::unexpected(error::loading);
   } else {
     log_info("Loaded module {}, address {}", path, static_cast<void *>(handle));
+    create_module_heap(handle);
     return handle;
   }
 }
@@ -70,12 +108,19 @@ void surge::module::unload(handle_t module) noexcept {
   } else {
     log_info("Unloaded module {}", static_cast<void *>(module));
   }
+
+  // Only after the module's static destructors have run
+  destroy_module_heap(module);
 }
 
-auto surge::module::get_func_addr(surge::module::handle_t module,
-                                       const char *func_name) -> std::optional<FARPROC> {
+auto surge::module::get_func_addr(surge::module::handle_t module, const char *func_name,
+                                  bool required) -> std::optional<FARPROC> {
   const auto addr{GetProcAddress(module, func_name)};
   if (!addr) {
+    if (!required) {
+      return {};
+    }
+
     const auto error_code{GetLastError()};
     LPSTR error_txt{nullptr};
     FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM
@@ -100,11 +145,15 @@ auto surge::module::set_module_path() noexcept -> bool {
 
 #else
 
-auto surge::module::get_func_addr(surge::module::handle_t module,
-                                  const char *func_name) -> std::optional<void *> {
+auto surge::module::get_func_addr(surge::module::handle_t module, const char *func_name,
+                                  bool required) -> std::optional<void *> {
   (void)dlerror();
   auto addr{dlsym(module, func_name)};
   if (!addr) {
+    if (!required) {
+      return {};
+    }
+
     log_warn("Unable to obtain handle to function {} in module {}: {}", func_name, module,
              dlerror());
     return {};
@@ -136,6 +185,7 @@ auto surge::module::load(const char *path) noexcept -> tl::expected<handle_t, er
     return tl::unexpected(error::loading);
   } else {
     log_info("Loaded module {}, address {}", path, handle);
+    create_module_heap(handle);
     return handle;
   }
 }
@@ -153,12 +203,24 @@ void surge::module::unload(handle_t module) noexcept {
   } else {
     log_info("Unloaded module {}", module);
   }
+
+  // Only after the module's static destructors have run
+  destroy_module_heap(module);
 }
 
 auto surge::module::set_module_path() noexcept -> bool { return true; }
 
 #endif
 
+auto surge::module::get_heap(handle_t module) noexcept -> allocators::mimalloc::heap_t * {
+  const auto it{module_heaps.find(module)};
+  return it != module_heaps.end() ? it->second : nullptr;
+}
+
+auto surge::module::get_heap_usage(handle_t module) noexcept -> usize {
+  return allocators::mimalloc::heap_used_bytes(get_heap(module));
+}
+
 auto surge::module::get_gl_api(handle_t module) noexcept -> tl::expected<gl_api, error> {
   // on_load
   const auto on_load_addr{get_func_addr(module, "gl_on_load")};
@@ -209,6 +271,9 @@ auto surge::module::get_gl_api(handle_t module) noexcept -> tl::expected<gl_api,
     return tl::unexpected{error::symbol_retrival};
   }
 
+  // build_update_graph, optional
+  const auto build_update_graph_addr{get_func_addr(module, "gl_build_update_graph", false)};
+
   // clang-format off
   return gl_api{
     reinterpret_cast<gl_api::on_load_t>(on_load_addr.value()),
@@ -217,7 +282,10 @@ auto surge::module::get_gl_api(handle_t module) noexcept -> tl::expected<gl_api,
     reinterpret_cast<gl_api::update_t>(update_addr.value()),
     reinterpret_cast<gl_api::keyboard_event_t>(keyboard_event_addr.value()),
     reinterpret_cast<gl_api::mouse_button_event_t>(mouse_button_event_addr.value()),
-    reinterpret_cast<gl_api::mouse_scroll_event_t>(mouse_scroll_event_addr.value())
+    reinterpret_cast<gl_api::mouse_scroll_event_t>(mouse_scroll_event_addr.value()),
+    build_update_graph_addr
+      ? reinterpret_cast<gl_api::build_update_graph_t>(build_update_graph_addr.value())
+      : nullptr
   };
   // clang-format on
 }
@@ -272,6 +340,9 @@ auto surge::module::get_vk_api(handle_t module) noexcept -> tl::expected<vk_api,
     return tl::unexpected{error::symbol_retrival};
   }
 
+  // build_update_graph, optional
+  const auto build_update_graph_addr{get_func_addr(module, "vk_build_update_graph", false)};
+
   // clang-format off
   return vk_api{
     reinterpret_cast<vk_api::on_load_t>(on_load_addr.value()),
@@ -280,11 +351,59 @@ auto surge::module::get_vk_api(handle_t module) noexcept -> tl::expected<vk_api,
     reinterpret_cast<vk_api::update_t>(update_addr.value()),
     reinterpret_cast<vk_api::keyboard_event_t>(keyboard_event_addr.value()),
     reinterpret_cast<vk_api::mouse_button_event_t>(mouse_button_event_addr.value()),
-    reinterpret_cast<vk_api::mouse_scroll_event_t>(mouse_scroll_event_addr.value())
+    reinterpret_cast<vk_api::mouse_scroll_event_t>(mouse_scroll_event_addr.value()),
+    build_update_graph_addr
+      ? reinterpret_cast<vk_api::build_update_graph_t>(build_update_graph_addr.value())
+      : nullptr
   };
   // clang-format on
 }
 
+/*
+ * The graph is built on the engine heap rather than the module heap: it lives across frames and
+ * taskflow may recycle its nodes after the module is gone.
+ */
+auto surge::module::build_update_graph(const gl_api &api, tf::Taskflow &graph,
+                                       update_frame &frame) noexcept -> std::optional<error> {
+  graph.clear();
+  frame.status = 0;
+
+  if (api.build_update_graph == nullptr) {
+    return {};
+  }
+
+  const auto result{api.build_update_graph(graph, frame)};
+  if (result != 0) {
+    log_error("Module returned error {} while building its update graph", result);
+    graph.clear();
+    return error::update_graph_build;
+  }
+
+  log_info("Module update graph built with {} tasks", graph.num_tasks());
+  return {};
+}
+
+auto surge::module::build_update_graph(const vk_api &api, tf::Taskflow &graph,
+                                       update_frame &frame, renderer::vk::context ctx) noexcept
+    -> std::optional<error> {
+  graph.clear();
+  frame.status = 0;
+
+  if (api.build_update_graph == nullptr) {
+    return {};
+  }
+
+  const auto result{api.build_update_graph(graph, frame, ctx)};
+  if (result != 0) {
+    log_error("Module returned error {} while building its update graph", result);
+    graph.clear();
+    return error::update_graph_build;
+  }
+
+  log_info("Module update graph built with {} tasks", graph.num_tasks());
+  return {};
+}
+
 auto surge::module::reload(handle_t module) noexcept -> tl::expected<handle_t, error> {
   // Get module file name
   const auto module_file_name{get_name(module)};
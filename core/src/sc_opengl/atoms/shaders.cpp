@@ -24,11 +24,11 @@ static auto load_and_compile_shader(const char *p, GLenum shader_type) noexcept
   using namespace surge;
   log_info("Loading shader file {}", p);
 
-  files::file file{};
+  files::mapping file{};
 
   if (shader_type == GL_VERTEX_SHADER || shader_type == GL_FRAGMENT_SHADER
       || shader_type == GL_COMPUTE_SHADER) {
-    file = files::load_file(p, true);
+    file = files::map_file(p);
   } else {
     log_error("Unrecognized shader type {}", shader_type);
     return tl::unexpected(surge::error::unrecognized_shader);
@@ -39,14 +39,15 @@ static auto load_and_compile_shader(const char *p, GLenum shader_type) noexcept
     return tl::unexpected(surge::error::shader_load_error);
   }
 
-  // Get the source code in GL format
-  auto file_source{static_cast<const GLchar *>(static_cast<void *>(file.value().data()))};
+  // Get the source code in GL format. The mapping is not null terminated, so its length is passed
+  auto file_source{reinterpret_cast<const GLchar *>(file->data())}; // NOLINT
+  const auto file_length{static_cast<GLint>(file->size())};
 
   // Create an empty shader handle
   const GLuint shader_handle_tmp = glCreateShader(shader_type);
 
   // Send the shader source code to GL
-  glShaderSource(shader_handle_tmp, 1, &file_source, nullptr);
+  glShaderSource(shader_handle_tmp, 1, &file_source, &file_length);
 
   // Compile the shader
   glCompileShader(shader_handle_tmp);
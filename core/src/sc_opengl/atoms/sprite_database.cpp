@@ -54,7 +54,19 @@ struct surge::gl_atom::sprite_database::database_t {
   GLuint VAO{0};
 };
 
-void wait_buffer(surge::gl_atom::sprite_database::database sdb, surge::usize index) {
+static surge::allocators::pool<surge::gl_atom::sprite_database::database_t, 8> database_pool{};
+
+static auto resolve(surge::gl_atom::sprite_database::database sdb_handle) noexcept
+    -> surge::gl_atom::sprite_database::database_t * {
+  auto sdb{database_pool.get(sdb_handle)};
+  if (sdb == nullptr) {
+    log_error("Sprite database handle {}:{} is stale or invalid", sdb_handle.index,
+              sdb_handle.generation);
+  }
+  return sdb;
+}
+
+static void wait_buffer(surge::gl_atom::sprite_database::database_t *sdb, surge::usize index) {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::wait_buffer");
@@ -75,7 +87,8 @@ void wait_buffer(surge::gl_atom::sprite_database::database sdb, surge::usize ind
   }
 }
 
-void lock_and_advance_buffer(surge::gl_atom::sprite_database::database sdb, surge::usize index) {
+static void lock_and_advance_buffer(surge::gl_atom::sprite_database::database_t *sdb,
+                                    surge::usize index) {
   auto &fence{sdb->fences[index]};
 
   if (fence == nullptr) {
@@ -86,16 +99,25 @@ void lock_and_advance_buffer(surge::gl_atom::sprite_database::database sdb, surg
   }
 }
 
-void surge::gl_atom::sprite_database::wait_idle(database sdb) noexcept {
+static void wait_all_buffers(surge::gl_atom::sprite_database::database_t *sdb) {
+  for (surge::usize i = 0; i < sdb->buffer_redundancy; i++) {
+    wait_buffer(sdb, i);
+  }
+}
+
+void surge::gl_atom::sprite_database::wait_idle(database sdb_handle) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::wait_idle");
   TracyGpuZone("GPU surge::gl_atom::sprite::wait_idle");
 #endif
 
-  for (usize i = 0; i < sdb->buffer_redundancy; i++) {
-    wait_buffer(sdb, i);
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
   }
+
+  wait_all_buffers(sdb);
 }
 
 auto surge::gl_atom::sprite_database::create(database_create_info ci) noexcept
@@ -107,25 +129,28 @@ auto surge::gl_atom::sprite_database::create(database_create_info ci) noexcept
 #endif
 
   // Alloc instance
-  auto sdb{static_cast<database>(allocators::mimalloc::malloc(sizeof(database_t)))};
+  const auto sdb_handle{database_pool.create()};
 
-  if (sdb == nullptr) {
+  if (!sdb_handle) {
     log_error("Unable to allocate sprite database instance");
     return tl::unexpected{sdb_instance_alloc};
   }
 
-  new (sdb)(database_t)();
+  auto sdb{database_pool.get(*sdb_handle)};
 
   // Read create info
   sdb->max_sprites = ci.max_sprites;
   sdb->buffer_redundancy = ci.buffer_redundancy;
 
-  // Alloc fences array
-  sdb->fences
-      = static_cast<GLsync *>(allocators::mimalloc::calloc(sdb->buffer_redundancy, sizeof(GLsync)));
+  // Alloc fences array. Databases live in an engine pool, so their memory must outlive module heaps
+  {
+    const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+    sdb->fences = static_cast<GLsync *>(
+        allocators::mimalloc::calloc(sdb->buffer_redundancy, sizeof(GLsync)));
+  }
 
   if (sdb->fences == nullptr) {
-
+    database_pool.destroy(*sdb_handle);
     log_error("Unable to allocate sprite databese fence array");
     return tl::unexpected{sdb_fenc_alloc};
   }
@@ -196,22 +221,27 @@ auto surge::gl_atom::sprite_database::create(database_create_info ci) noexcept
                         reinterpret_cast<const void *>(3 * sizeof(float))); // NOLINT
 
   // Done
-  log_info("Created new sprite database, handle {} using {} B of video memory",
-           static_cast<void *>(sdb), total_buffer_size);
+  log_info("Created new sprite database, handle {}:{} using {} B of video memory",
+           sdb_handle->index, sdb_handle->generation, total_buffer_size);
 
-  return sdb;
+  return *sdb_handle;
 }
 
-void surge::gl_atom::sprite_database::destroy(database sdb) noexcept {
+void surge::gl_atom::sprite_database::destroy(database sdb_handle) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::destroy");
   TracyGpuZone("GPU surge::gl_atom::sprite::destroy");
 #endif
 
-  log_info("Destroying sprite database, handle {}", static_cast<void *>(sdb));
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
 
-  wait_idle(sdb);
+  log_info("Destroying sprite database, handle {}:{}", sdb_handle.index, sdb_handle.generation);
+
+  wait_all_buffers(sdb);
 
   // Delete vertex buffers
   glDeleteBuffers(1, &(sdb->EBO));
@@ -229,20 +259,25 @@ void surge::gl_atom::sprite_database::destroy(database sdb) noexcept {
   allocators::mimalloc::free(static_cast<void *>(sdb->fences));
 
   // Free instance
-  allocators::mimalloc::free(static_cast<void *>(sdb));
+  database_pool.destroy(sdb_handle);
 }
 
-void surge::gl_atom::sprite_database::begin_add(database sdb) noexcept {
+void surge::gl_atom::sprite_database::begin_add(database sdb_handle) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::begin_add");
   TracyGpuZone("GPU surge::gl_atom::sprite::begin_add");
 #endif
 
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
+
   wait_buffer(sdb, sdb->write_buffer);
 }
 
-void surge::gl_atom::sprite_database::add(database sdb, GLuint64 texture_handle,
+void surge::gl_atom::sprite_database::add(database sdb_handle, GLuint64 texture_handle,
                                           const glm::mat4 &model_matrix,
                                           const glm::vec4 &color_mod) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
@@ -250,6 +285,11 @@ void surge::gl_atom::sprite_database::add(database sdb, GLuint64 texture_handle,
   ZoneScopedN("surge::gl_atom::sprite::add");
 #endif
 
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
+
   using std::memcpy;
 
   if (sdb->write_idx < sdb->max_sprites) {
@@ -286,7 +326,7 @@ void surge::gl_atom::sprite_database::add(database sdb, GLuint64 texture_handle,
   add(sdb, texture_handle, model, color_mod);
 }
 
-void surge::gl_atom::sprite_database::add_view(database sdb, GLuint64 texture_handle,
+void surge::gl_atom::sprite_database::add_view(database sdb_handle, GLuint64 texture_handle,
                                                glm::mat4 model_matrix, glm::vec4 image_view,
                                                glm::vec2 img_dims,
                                                const glm::vec4 &color_mod) noexcept {
@@ -297,17 +337,13 @@ void surge::gl_atom::sprite_database::add_view(database sdb, GLuint64 texture_ha
   ZoneScopedN("surge::gl_atom::sprite::add_view");
 #endif
 
-  if (sdb->write_idx < sdb->max_sprites) {
-    const auto u0{image_view[0]};
-    const auto v0{image_view[1]};
-
-    const auto w{image_view[2]};
-    const auto h{image_view[3]};
-
-    const auto W{img_dims[0]};
-    const auto H{img_dims[1]};
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
 
-    const glm::vec4 view_data{w / W, h / H, u0 / W, 1.0f - (v0 + h) / H};
+  if (sdb->write_idx < sdb->max_sprites) {
+    const auto view_data{make_view(image_view, img_dims)};
 
     sprite_info si{};
     si.texture_handle = texture_handle;
@@ -343,24 +379,89 @@ void surge::gl_atom::sprite_database::add_view(database sdb, GLuint64 handle, co
   add_view(sdb, handle, model, image_view, img_dims, color_mod);
 }
 
-void surge::gl_atom::sprite_database::add_depth(database sdb, GLuint64 texture, GLuint64 depth_map,
-                                                glm::mat4 model) noexcept {
+auto surge::gl_atom::sprite_database::reserve(database sdb_handle, usize count) noexcept
+    -> slot_range {
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return {};
+  }
+
+  const auto available{sdb->max_sprites - sdb->write_idx};
+
+  if (count > available) {
+    log_warn("Sprite database {} capacity exceeded. Reserving {} of {} requested slots",
+             static_cast<void *>(sdb), available, count);
+    count = available;
+  }
+
+  const slot_range range{sdb->write_idx, count};
+  sdb->write_idx += count;
+  return range;
+}
+
+void surge::gl_atom::sprite_database::write(database sdb_handle, usize slot,
+                                            GLuint64 texture_handle, const glm::mat4 &model_matrix,
+                                            const glm::vec4 &color_mod,
+                                            const glm::vec4 &view) noexcept {
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
+
+  using std::memcpy;
+
+  sprite_info si{};
+  si.texture_handle = texture_handle;
+  memcpy(si.color_mod, glm::value_ptr(color_mod), 4 * sizeof(float));
+  memcpy(si.model, glm::value_ptr(model_matrix), 16 * sizeof(float));
+  memcpy(si.view, glm::value_ptr(view), 4 * sizeof(float));
+
+  sdb->buffer_data[sdb->write_buffer * sdb->max_sprites + slot] = si;
+}
+
+auto surge::gl_atom::sprite_database::make_view(const glm::vec4 &image_view,
+                                                const glm::vec2 &img_dims) noexcept -> glm::vec4 {
+  const auto u0{image_view[0]};
+  const auto v0{image_view[1]};
+
+  const auto w{image_view[2]};
+  const auto h{image_view[3]};
+
+  const auto W{img_dims[0]};
+  const auto H{img_dims[1]};
+
+  return glm::vec4{w / W, h / H, u0 / W, 1.0f - (v0 + h) / H};
+}
+
+void surge::gl_atom::sprite_database::add_depth(database sdb_handle, GLuint64 texture,
+                                                GLuint64 depth_map, glm::mat4 model) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::add_depth");
 #endif
+
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
+
   sdb->depth_texture_handle = texture;
   sdb->depth_map_handle = depth_map;
   sdb->depth_model = model;
 }
 
-void surge::gl_atom::sprite_database::draw(database sdb) noexcept {
+void surge::gl_atom::sprite_database::draw(database sdb_handle) noexcept {
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
   ZoneScopedN("surge::gl_atom::sprite::draw");
   TracyGpuZone("GPU surge::gl_atom::sprite::draw");
 #endif
 
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return;
+  }
+
   // Regular sprites
   if (sdb->write_idx != 0) {
     glUseProgram(sdb->sprite_shader);
@@ -406,11 +507,23 @@ auto surge::gl_atom::sprite_database::place_sprite(const glm::vec2 &pos, const g
 
 #ifdef SURGE_BUILD_TYPE_Debug
 
-auto surge::gl_atom::sprite_database::get_sprites_in_buffer(database sdb) noexcept -> usize {
+auto surge::gl_atom::sprite_database::get_sprites_in_buffer(database sdb_handle) noexcept
+    -> usize {
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return 0;
+  }
+
   return sdb->write_idx;
 }
 
-auto surge::gl_atom::sprite_database::get_current_buffer_idx(database sdb) noexcept -> usize {
+auto surge::gl_atom::sprite_database::get_current_buffer_idx(database sdb_handle) noexcept
+    -> usize {
+  const auto sdb{resolve(sdb_handle)};
+  if (sdb == nullptr) {
+    return 0;
+  }
+
   return sdb->write_buffer;
 }
 
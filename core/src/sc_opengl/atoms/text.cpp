@@ -25,13 +25,17 @@
 #endif
 
 static auto FT_malloc(FT_Memory, long size) noexcept -> void * {
-  return surge::allocators::mimalloc::malloc(static_cast<surge::usize>(size));
+  return surge::allocators::mimalloc::malloc(static_cast<surge::usize>(size),
+                                             surge::allocators::accounting::tag::fonts);
 }
 
-static void FT_free(FT_Memory, void *block) noexcept { surge::allocators::mimalloc::free(block); }
+static void FT_free(FT_Memory, void *block) noexcept {
+  surge::allocators::mimalloc::free(block, surge::allocators::accounting::tag::fonts);
+}
 
 static auto FT_realloc(FT_Memory, long, long new_size, void *block) noexcept -> void * {
-  return surge::allocators::mimalloc::realloc(block, static_cast<surge::usize>(new_size));
+  return surge::allocators::mimalloc::realloc(block, static_cast<surge::usize>(new_size),
+                                              surge::allocators::accounting::tag::fonts);
 }
 
 // NOLINTNEXTLINE
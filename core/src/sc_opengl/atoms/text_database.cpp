@@ -177,7 +177,7 @@ auto surge::gl_atom::text_database::glyph_cache::create(create_info ci)
   FT_Add_Default_Modules(ft_library);
 
   // Create font faces
-  vector<FT_Face> faces{};
+  small_vector<FT_Face, 8> faces{};
   faces.reserve(num_fonts);
 
   for (usize i = 0; i < num_fonts; i++) {
@@ -1,6 +1,446 @@
 #include "sc_tasks.hpp"
 
+#include "sc_logging.hpp"
+#include "sc_options.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+// clang-format off
+#if defined(SURGE_SYSTEM_Linux)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#elif defined(SURGE_SYSTEM_Windows)
+#  include <windows.h>
+#endif
+// clang-format on
+
+// Capacity of each thread's scratch arena
+static constexpr surge::usize scratch_capacity{4 * 1024 * 1024};
+
+// Smallest chunk auto_grain() hands out, and how many chunks it aims for per worker
+static constexpr surge::usize min_grain{256};
+static constexpr surge::usize chunks_per_worker{4};
+
+static thread_local surge::allocators::mimalloc::arena *thread_scratch{nullptr};
+static thread_local surge::usize task_depth{0};
+
+// Priority class of the executor the calling thread works for. Threads outside the executors
+// submit nested work to the frame critical one
+static thread_local surge::tasks::priority worker_class{surge::tasks::priority::frame_critical};
+
+/*
+ * Resets the scratch arena of a worker once its outermost task exits. Tasks that wait on other
+ * tasks may run them inline on the same worker, hence the depth count.
+ */
+class scratch_observer : public tf::ObserverInterface {
+public:
+  void set_up(std::size_t) override {}
+
+  void on_entry(tf::WorkerView, tf::TaskView) override { task_depth++; }
+
+  void on_exit(tf::WorkerView, tf::TaskView) override {
+    task_depth--;
+    if (task_depth == 0 && thread_scratch != nullptr) {
+      thread_scratch->reset();
+    }
+  }
+};
+
+/*
+ * Platform thread controls
+ */
+using surge::config::cpu_set;
+using surge::config::max_cpus;
+using surge::config::thread_priority;
+using surge::tasks::priority;
+
+#if defined(SURGE_SYSTEM_Linux)
+
+static auto process_cpus() -> cpu_set {
+  cpu_set cpus{};
+  cpu_set_t set{};
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (surge::usize i = 0; i < max_cpus && i < CPU_SETSIZE; i++) {
+      if (CPU_ISSET(i, &set)) {
+        cpus.set(i);
+      }
+    }
+  }
+  return cpus;
+}
+
+static auto set_thread_affinity(const cpu_set &cpus) -> bool {
+  cpu_set_t set{};
+  CPU_ZERO(&set);
+  for (surge::usize i = 0; i < max_cpus && i < CPU_SETSIZE; i++) {
+    if (cpus.test(i)) {
+      CPU_SET(i, &set);
+    }
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// Linux applies nice values per thread. Raising the priority needs CAP_SYS_NICE
+static auto set_thread_priority(thread_priority p) -> bool {
+  const int nice_value{p == thread_priority::low ? 10 : (p == thread_priority::high ? -5 : 0)};
+  const auto tid{static_cast<id_t>(syscall(SYS_gettid))};
+  return setpriority(PRIO_PROCESS, tid, nice_value) == 0;
+}
+
+// Counts one CPU per core, using the first SMT sibling the kernel lists for each core
+static auto physical_cores(const cpu_set &cpus) -> surge::usize {
+  cpu_set cores{};
+  for (surge::usize i = 0; i < max_cpus; i++) {
+    if (!cpus.test(i)) {
+      continue;
+    }
+
+    std::array<char, 96> path{};
+    std::snprintf(path.data(), path.size(),
+                  "/sys/devices/system/cpu/cpu%zu/topology/thread_siblings_list", i);
+
+    auto first_sibling{i};
+    if (auto f{std::fopen(path.data(), "r")}; f != nullptr) {
+      if (std::fscanf(f, "%zu", &first_sibling) != 1 || first_sibling >= max_cpus) {
+        first_sibling = i;
+      }
+      std::fclose(f);
+    }
+    cores.set(first_sibling);
+  }
+  return cores.count();
+}
+
+#elif defined(SURGE_SYSTEM_Windows)
+
+// Only the first processor group (64 CPUs) is handled
+static auto to_mask(const cpu_set &cpus) -> DWORD_PTR {
+  DWORD_PTR mask{0};
+  for (surge::usize i = 0; i < 64; i++) {
+    if (cpus.test(i)) {
+      mask |= DWORD_PTR{1} << i;
+    }
+  }
+  return mask;
+}
+
+static auto process_cpus() -> cpu_set {
+  cpu_set cpus{};
+  DWORD_PTR process_mask{0};
+  DWORD_PTR system_mask{0};
+  if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) != 0) {
+    for (surge::usize i = 0; i < 64; i++) {
+      if ((process_mask >> i) & 1) {
+        cpus.set(i);
+      }
+    }
+  }
+  return cpus;
+}
+
+static auto set_thread_affinity(const cpu_set &cpus) -> bool {
+  return SetThreadAffinityMask(GetCurrentThread(), to_mask(cpus)) != 0;
+}
+
+static auto set_thread_priority(thread_priority p) -> bool {
+  const int priority{p == thread_priority::low
+                         ? THREAD_PRIORITY_BELOW_NORMAL
+                         : (p == thread_priority::high ? THREAD_PRIORITY_ABOVE_NORMAL
+                                                       : THREAD_PRIORITY_NORMAL)};
+  return SetThreadPriority(GetCurrentThread(), priority) != 0;
+}
+
+static auto physical_cores(const cpu_set &cpus) -> surge::usize {
+  DWORD length{0};
+  GetLogicalProcessorInformation(nullptr, &length);
+
+  surge::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(
+      length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+  if (info.empty() || GetLogicalProcessorInformation(info.data(), &length) == 0) {
+    return cpus.count();
+  }
+
+  const auto mask{to_mask(cpus)};
+  surge::usize cores{0};
+  for (const auto &i : info) {
+    if (i.Relationship == RelationProcessorCore && (i.ProcessorMask & mask) != 0) {
+      cores++;
+    }
+  }
+  return cores;
+}
+
+#else
+
+static auto process_cpus() -> cpu_set {
+  cpu_set cpus{};
+  for (surge::usize i = 0; i < std::thread::hardware_concurrency() && i < max_cpus; i++) {
+    cpus.set(i);
+  }
+  return cpus;
+}
+
+static auto set_thread_affinity(const cpu_set &) -> bool { return false; }
+static auto set_thread_priority(thread_priority) -> bool { return false; }
+static auto physical_cores(const cpu_set &cpus) -> surge::usize { return cpus.count(); }
+
+#endif
+
+/*
+ * Executor configuration
+ */
+static surge::config::executor_attrs executor_settings{};
+static cpu_set worker_pool{};
+static bool executor_created{false};
+
+// The i-th CPU of a set, wrapping around
+static auto nth_cpu(const cpu_set &cpus, surge::usize n) -> surge::usize {
+  n %= cpus.count();
+  for (surge::usize i = 0; i < max_cpus; i++) {
+    if (cpus.test(i) && n-- == 0) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Applies the configured affinity and priority to each worker before it starts taking tasks. Only
+ * frame critical workers are pinned one per core. The other classes float over the worker CPUs and
+ * background workers always run at low priority, so the OS favors frame work when they compete.
+ */
+class worker_setup : public tf::WorkerInterface {
+public:
+  explicit worker_setup(priority p) : cls{p} {}
+
+  void scheduler_prologue(tf::Worker &w) override {
+    worker_class = cls;
+
+    if (executor_settings.pin_workers || executor_settings.worker_cpus.any()
+        || executor_settings.main_thread_core >= 0) {
+      cpu_set cpus{};
+      if (executor_settings.pin_workers && cls == priority::frame_critical) {
+        cpus.set(nth_cpu(worker_pool, w.id()));
+      } else {
+        cpus = worker_pool;
+      }
+
+      if (!set_thread_affinity(cpus)) {
+        log_warn("Unable to set the CPU affinity of worker {}", w.id());
+      }
+    }
+
+    const auto p{cls == priority::background ? thread_priority::low
+                                             : executor_settings.worker_priority};
+    if (p != thread_priority::normal && !set_thread_priority(p)) {
+      log_warn("Unable to set the priority of worker {}", w.id());
+    }
+  }
+
+  void scheduler_epilogue(tf::Worker &, std::exception_ptr) override {}
+
+private:
+  priority cls;
+};
+
+static auto resolve_worker_pool(const surge::config::executor_attrs &attrs) -> cpu_set {
+  const auto available{process_cpus()};
+  auto pool{available};
+
+  if (attrs.worker_cpus.any()) {
+    pool = attrs.worker_cpus & available;
+    if (pool.none()) {
+      log_warn("None of the configured worker CPUs is available. Using every CPU");
+      pool = available;
+    }
+  }
+
+  if (attrs.main_thread_core >= 0 && pool.count() > 1) {
+    pool.reset(static_cast<surge::usize>(attrs.main_thread_core));
+  }
+
+  return pool;
+}
+
+static auto resolve_worker_count() -> surge::usize {
+  if (executor_settings.worker_count != 0) {
+    return executor_settings.worker_count;
+  }
+
+  auto count{executor_settings.physical_cores_only ? physical_cores(worker_pool)
+                                                   : worker_pool.count()};
+
+  // An unpinned main thread competes with the workers for the same cores
+  if (executor_settings.main_thread_core < 0 && count > 1) {
+    count--;
+  }
+
+  return count == 0 ? 1 : count;
+}
+
+void surge::tasks::executor::configure(const config::executor_attrs &attrs) {
+  if (executor_created) {
+    log_warn("Task executor already running. Ignoring the new configuration");
+    return;
+  }
+
+  executor_settings = attrs;
+  worker_pool = resolve_worker_pool(attrs);
+
+  if (attrs.main_thread_core >= 0) {
+    const auto core{static_cast<usize>(attrs.main_thread_core)};
+    cpu_set main_cpu{};
+    if (core < max_cpus) {
+      main_cpu.set(core);
+    }
+
+    if (main_cpu.none() || !set_thread_affinity(main_cpu)) {
+      log_warn("Unable to pin the main thread to core {}", attrs.main_thread_core);
+    } else {
+      log_info("Main thread pinned to core {}", core);
+    }
+  }
+}
+
+static auto class_worker_count(priority p, surge::usize frame_workers) -> surge::usize {
+  switch (p) {
+  case priority::normal:
+    return executor_settings.normal_workers != 0 ? executor_settings.normal_workers
+                                                 : std::max(frame_workers / 2, surge::usize{1});
+  case priority::background:
+    return executor_settings.background_workers != 0
+               ? executor_settings.background_workers
+               : std::max(frame_workers / 4, surge::usize{1});
+  default:
+    return frame_workers;
+  }
+}
+
+static auto class_name(priority p) -> const char * {
+  switch (p) {
+  case priority::normal:
+    return "normal";
+  case priority::background:
+    return "background";
+  default:
+    return "frame critical";
+  }
+}
+
+static auto create_executor(priority p) -> tf::Executor {
+  if (worker_pool.none()) {
+    worker_pool = resolve_worker_pool(executor_settings);
+  }
+
+  const auto workers{class_worker_count(p, resolve_worker_count())};
+  log_info("Starting {} task executor with {} workers", class_name(p), workers);
+
+  executor_created = true;
+  return tf::Executor{workers, tf::make_worker_interface<worker_setup>(p)};
+}
+
 auto surge::tasks::executor::get() -> tf::Executor & {
-  static tf::Executor e{std::thread::hardware_concurrency() - 1};
+  static tf::Executor e{create_executor(priority::frame_critical)};
+  static const auto observer{e.make_observer<scratch_observer>()};
   return e;
+}
+
+auto surge::tasks::executor::get(priority p) -> tf::Executor & {
+  switch (p) {
+  case priority::normal: {
+    static tf::Executor e{create_executor(priority::normal)};
+    static const auto observer{e.make_observer<scratch_observer>()};
+    return e;
+  }
+  case priority::background: {
+    static tf::Executor e{create_executor(priority::background)};
+    static const auto observer{e.make_observer<scratch_observer>()};
+    return e;
+  }
+  default:
+    return get();
+  }
+}
+
+void surge::tasks::run_and_wait(tf::Taskflow &flow) {
+  auto &e{executor::get(worker_class)};
+  if (e.this_worker_id() >= 0) {
+    e.corun(flow);
+  } else {
+    e.run(flow).wait();
+  }
+}
+
+auto surge::tasks::auto_grain(usize count) noexcept -> usize {
+  const auto workers{executor::get(worker_class).num_workers()};
+  const auto chunks{std::max(workers * chunks_per_worker, usize{1})};
+  return std::max((count + chunks - 1) / chunks, min_grain);
+}
+
+/*
+ * Frame deadline. The deadline is kept in steady clock ticks, 0 meaning no frame is running, and
+ * the condition variable wakes yielding background workers when the frame ends.
+ */
+using frame_clock = std::chrono::steady_clock;
+
+static std::atomic<frame_clock::rep> frame_deadline{0};
+static std::mutex frame_mutex{};
+static std::condition_variable frame_done{};
+
+void surge::tasks::begin_frame(double budget) noexcept {
+  const auto deadline{frame_clock::now()
+                      + std::chrono::duration_cast<frame_clock::duration>(
+                          std::chrono::duration<double>{budget})};
+  frame_deadline.store(deadline.time_since_epoch().count(), std::memory_order_release);
+}
+
+void surge::tasks::end_frame() noexcept {
+  {
+    const std::lock_guard lock{frame_mutex};
+    frame_deadline.store(0, std::memory_order_release);
+  }
+  frame_done.notify_all();
+}
+
+void surge::tasks::yield_to_frame() noexcept {
+  if (worker_class != priority::background) {
+    return;
+  }
+
+  const auto deadline_ticks{frame_deadline.load(std::memory_order_acquire)};
+  if (deadline_ticks == 0) {
+    return;
+  }
+
+  const frame_clock::time_point deadline{frame_clock::duration{deadline_ticks}};
+  const auto margin{std::chrono::duration_cast<frame_clock::duration>(
+      std::chrono::duration<double>{executor_settings.background_yield})};
+  const auto now{frame_clock::now()};
+  if (now + margin < deadline || now >= deadline) {
+    return;
+  }
+
+  std::unique_lock lock{frame_mutex};
+  frame_done.wait_until(lock, deadline, [&] {
+    return frame_deadline.load(std::memory_order_acquire) != deadline_ticks;
+  });
+}
+
+auto surge::tasks::scratch() -> allocators::mimalloc::arena & {
+  if (thread_scratch == nullptr) {
+    // The arena lives as long as the thread, not as long as the active module heap
+    const allocators::mimalloc::heap_scope engine_heap{allocators::mimalloc::heap_get_backing()};
+    static thread_local allocators::mimalloc::arena a{scratch_capacity};
+    thread_scratch = &a;
+  }
+  return *thread_scratch;
 }
\ No newline at end of file
@@ -31,7 +31,7 @@ auto surge::vk_atom::descriptor::allocator::get_pool(VkDevice device) -> VkDescr
 auto surge::vk_atom::descriptor::allocator::create_pool(VkDevice device, u32 set_count,
                                                         std::span<pool_size_ratio> pool_ratios)
     -> VkDescriptorPool {
-  vector<VkDescriptorPoolSize> poolSizes{};
+  small_vector<VkDescriptorPoolSize, 8> poolSizes{};
 
   for (const auto &ratio : pool_ratios) {
     poolSizes.push_back(VkDescriptorPoolSize{
@@ -12,7 +12,7 @@ auto surge::vk_atom::shader::load_shader_module(renderer::vk::context ctx,
     -> tl::expected<VkShaderModule, error> {
   log_info("Loading vulkan shader module {}", path);
 
-  const auto file{files::load_file(path, false)};
+  const auto file{files::map_file(path)};
 
   if (!file) {
     log_error("Unable to load Vulkan shader file {}", path);
@@ -60,8 +60,8 @@ auto surge::vk_atom::shader::create_shader_object(renderer::vk::context ctx,
   }
 
   // Load files
-  const auto vs_file{files::load_file(vertex_shader_path, false)};
-  const auto fs_file{files::load_file(fragment_shader_path, false)};
+  const auto vs_file{files::map_file(vertex_shader_path)};
+  const auto fs_file{files::map_file(fragment_shader_path)};
 
   if (!vs_file) {
     log_error("Unable to load Vulkan vertex shader file {}", vertex_shader_path);
@@ -17,7 +17,8 @@ auto initialize(window::window_t w, const config::renderer_attrs &r_attrs,
   log_info("Initializing Vulkan");
 
   // Alloc context
-  auto ctx = static_cast<context>(allocators::mimalloc::malloc(sizeof(context_t)));
+  auto ctx = static_cast<context>(
+      allocators::mimalloc::malloc(sizeof(context_t), allocators::accounting::tag::vulkan));
   if (!ctx) {
     log_error("Unable to allocate memory for Vulkan context");
     return tl::unexpected{error::vk_ctx_alloc};
@@ -182,7 +183,7 @@ void terminate(context ctx) {
 
   // Free context
   ctx->~context_t();
-  allocators::mimalloc::free(ctx);
+  allocators::mimalloc::free(ctx, allocators::accounting::tag::vulkan);
 
   log_info("Vulkan context {} terminated", static_cast<void *>(ctx));
 }
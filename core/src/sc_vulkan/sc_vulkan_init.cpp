@@ -35,7 +35,7 @@ auto surge::renderer::vk::get_api_version() -> tl::expected<u32, error> {
   return vulkan_api_version;
 }
 
-auto surge::renderer::vk::get_required_extensions() -> tl::expected<vector<const char *>, error> {
+auto surge::renderer::vk::get_required_extensions() -> tl::expected<name_list, error> {
   log_info("Querying required Vulkan instance extensions");
 
   // GLFW extensions
@@ -47,7 +47,7 @@ auto surge::renderer::vk::get_required_extensions() -> tl::expected<vector<const
   }
 
   // NOLINTNEXTLINE
-  vector<const char *> required_extensions{glfw_extensions, glfw_extensions + glfw_extension_count};
+  name_list required_extensions{glfw_extensions, glfw_extensions + glfw_extension_count};
 
   // Debug handler (if validation layers are available)
 #ifdef SURGE_USE_VK_VALIDATION_LAYERS
@@ -63,8 +63,7 @@ auto surge::renderer::vk::get_required_extensions() -> tl::expected<vector<const
 }
 
 #ifdef SURGE_USE_VK_VALIDATION_LAYERS
-auto surge::renderer::vk::get_required_validation_layers()
-    -> tl::expected<vector<const char *>, error> {
+auto surge::renderer::vk::get_required_validation_layers() -> tl::expected<name_list, error> {
   using std::strcmp;
 
   log_info("Cheking available validation layers");
@@ -89,7 +88,7 @@ auto surge::renderer::vk::get_required_validation_layers()
     log_info("Available validation layer: {}", layer_properties.layerName);
   }
 
-  vector<const char *> required_layers{};
+  name_list required_layers{};
   required_layers.push_back("VK_LAYER_KHRONOS_validation");
 
   for (const auto &layer_name : required_layers) {
@@ -115,8 +114,8 @@ auto surge::renderer::vk::get_required_validation_layers()
 #endif
 
 #ifdef SURGE_USE_VK_VALIDATION_LAYERS
-auto surge::renderer::vk::build_instance(const vector<const char *> &required_extensions,
-                                         const vector<const char *> &required_validation_layers,
+auto surge::renderer::vk::build_instance(const name_list &required_extensions,
+                                         const name_list &required_validation_layers,
                                          const VkDebugUtilsMessengerCreateInfoEXT &dbg_msg_ci)
     -> tl::expected<VkInstance, error> {
   log_info("Creating Vulkan Instance");
@@ -153,7 +152,7 @@ auto surge::renderer::vk::build_instance(const vector<const char *> &required_ex
   return instance;
 }
 #else
-auto surge::renderer::vk::build_instance(const vector<const char *> &required_extensions)
+auto surge::renderer::vk::build_instance(const name_list &required_extensions)
     -> tl::expected<VkInstance, error> {
   log_info("Creating Vulkan Instance");
 
@@ -202,7 +201,7 @@ auto surge::renderer::vk::select_physical_device(VkInstance instance)
     return tl::unexpected{error::vk_phys_dev_enum};
   }
 
-  std::vector<VkPhysicalDevice> phys_devs(dev_count);
+  small_vector<VkPhysicalDevice, 4> phys_devs(dev_count);
   result = vkEnumeratePhysicalDevices(instance, &dev_count, phys_devs.data());
 
   if (result != VK_SUCCESS) {
@@ -305,7 +304,7 @@ auto surge::renderer::vk::find_queue_families(VkPhysicalDevice phys_dev) -> queu
   uint32_t queue_family_count{0};
   vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &queue_family_count, nullptr);
 
-  vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+  small_vector<VkQueueFamilyProperties, 8> queue_families(queue_family_count);
   vkGetPhysicalDeviceQueueFamilyProperties(phys_dev, &queue_family_count, queue_families.data());
 
   for (u32 i = 0; const auto &family : queue_families) {
@@ -328,7 +327,7 @@ auto surge::renderer::vk::find_queue_families(VkPhysicalDevice phys_dev) -> queu
 }
 
 auto surge::renderer::vk::get_required_device_extensions(VkPhysicalDevice phys_dev)
-    -> tl::expected<vector<const char *>, error> {
+    -> tl::expected<name_list, error> {
   using std::strcmp;
 
   log_info("Cheking device extensions");
@@ -350,7 +349,7 @@ auto surge::renderer::vk::get_required_device_extensions(VkPhysicalDevice phys_d
     return tl::unexpected{error::vk_phys_dev_ext_enum};
   }
 
-  vector<const char *> required_extensions{};
+  name_list required_extensions{};
   required_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
   required_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
   required_extensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
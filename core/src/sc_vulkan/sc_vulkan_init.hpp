@@ -12,21 +12,24 @@
 
 namespace surge::renderer::vk {
 
+// Extension and layer names. There are rarely more than a handful
+using name_list = small_vector<const char *, 8>;
+
 auto get_api_version() -> tl::expected<u32, error>;
 
-auto get_required_extensions() -> tl::expected<vector<const char *>, error>;
+auto get_required_extensions() -> tl::expected<name_list, error>;
 
 #ifdef SURGE_USE_VK_VALIDATION_LAYERS
-auto get_required_validation_layers() -> tl::expected<vector<const char *>, error>;
+auto get_required_validation_layers() -> tl::expected<name_list, error>;
 #endif
 
 #ifdef SURGE_USE_VK_VALIDATION_LAYERS
-auto build_instance(const vector<const char *> &required_extensions,
-                    const vector<const char *> &required_validation_layers,
+auto build_instance(const name_list &required_extensions,
+                    const name_list &required_validation_layers,
                     const VkDebugUtilsMessengerCreateInfoEXT &dbg_msg_ci)
     -> tl::expected<VkInstance, error>;
 #else
-auto build_instance(const vector<const char *> &required_extensions)
+auto build_instance(const name_list &required_extensions)
     -> tl::expected<VkInstance, error>;
 #endif
 
@@ -36,8 +39,7 @@ auto is_device_suitable(VkPhysicalDevice phys_dev) -> bool;
 
 auto find_queue_families(VkPhysicalDevice phys_dev) -> queue_family_indices;
 
-auto get_required_device_extensions(VkPhysicalDevice phys_dev)
-    -> tl::expected<vector<const char *>, error>;
+auto get_required_device_extensions(VkPhysicalDevice phys_dev) -> tl::expected<name_list, error>;
 
 auto create_logical_device(VkPhysicalDevice phys_dev) -> tl::expected<VkDevice, error>;
 
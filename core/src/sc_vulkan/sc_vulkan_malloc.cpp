@@ -4,54 +4,47 @@
 
 #include "sc_allocators.hpp"
 #include "sc_logging.hpp"
+#include "sc_memory_trace.hpp"
 #include "sc_options.hpp"
 
 #include <vulkan/vk_enum_string_helper.h>
 
-static auto vk_malloc(void *, size_t size, size_t alignment,
-                      [[maybe_unused]] VkSystemAllocationScope scope) -> void * {
-#ifdef SURGE_DEBUG_MEMORY
-  log_debug("Vk memory event with scope {}", static_cast<int>(scope));
-#endif
-  return surge::allocators::mimalloc::aligned_alloc(size, alignment);
+/*
+ * Driver and allocator objects may outlive the module that caused their creation, so Vulkan memory
+ * never comes from a module heap.
+ */
+static auto vk_malloc(void *, size_t size, size_t alignment, VkSystemAllocationScope) -> void * {
+  const surge::allocators::mimalloc::heap_scope engine_heap{
+      surge::allocators::mimalloc::heap_get_backing()};
+  return surge::allocators::mimalloc::aligned_alloc(size, alignment,
+                                                    surge::allocators::accounting::tag::vulkan);
 }
 
 static auto vk_realloc(void *, void *pOriginal, size_t size, size_t alignment,
-                       [[maybe_unused]] VkSystemAllocationScope scope) -> void * {
-#ifdef SURGE_DEBUG_MEMORY
-  log_debug("Vk memory event with scope {}", static_cast<int>(scope));
-#endif
-  return surge::allocators::mimalloc::aligned_realloc(pOriginal, size, alignment);
+                       VkSystemAllocationScope) -> void * {
+  const surge::allocators::mimalloc::heap_scope engine_heap{
+      surge::allocators::mimalloc::heap_get_backing()};
+  return surge::allocators::mimalloc::aligned_realloc(pOriginal, size, alignment,
+                                                      surge::allocators::accounting::tag::vulkan);
 }
 
 static void vk_free(void *, void *pMemory) {
-#ifdef SURGE_DEBUG_MEMORY
-  log_debug("Vk memory free event");
-#endif
-  surge::allocators::mimalloc::free(pMemory);
+  surge::allocators::mimalloc::free(pMemory, surge::allocators::accounting::tag::vulkan);
 }
 
-static void vk_internal_malloc([[maybe_unused]] void *, [[maybe_unused]] size_t size,
-                               [[maybe_unused]] VkInternalAllocationType type,
-                               [[maybe_unused]] VkSystemAllocationScope scope) {
+static void vk_internal_malloc(void *, [[maybe_unused]] size_t size, VkInternalAllocationType,
+                               VkSystemAllocationScope) {
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Vk internal malloc event:\n"
-            "size: {}\n"
-            "type: {}\n"
-            "scope: {}",
-            size, static_cast<int>(type), static_cast<int>(scope));
+  surge::allocators::trace::record_event(surge::allocators::trace::op::internal_alloc,
+                                         surge::allocators::accounting::tag::vulkan, nullptr, size);
 #endif
 }
 
-static void vk_internal_free([[maybe_unused]] void *, [[maybe_unused]] size_t size,
-                             [[maybe_unused]] VkInternalAllocationType type,
-                             [[maybe_unused]] VkSystemAllocationScope scope) {
+static void vk_internal_free(void *, [[maybe_unused]] size_t size, VkInternalAllocationType,
+                             VkSystemAllocationScope) {
 #ifdef SURGE_DEBUG_MEMORY
-  log_debug("Vk internal malloc free:\n"
-            "size: {}\n"
-            "type: {}\n"
-            "scope: {}",
-            size, static_cast<int>(type), static_cast<int>(scope));
+  surge::allocators::trace::record_event(surge::allocators::trace::op::internal_free,
+                                         surge::allocators::accounting::tag::vulkan, nullptr, size);
 #endif
 }
 
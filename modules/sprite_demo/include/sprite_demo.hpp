@@ -2,6 +2,7 @@
 #define SURGE_MODULE_SPRITE_DEMO
 
 #include "sc_glfw_includes.hpp"
+#include "sc_module.hpp"
 #include "sc_options.hpp"
 
 #if defined(SURGE_COMPILER_Clang)                                                                  \
@@ -25,6 +26,9 @@ SURGE_MODULE_EXPORT auto gl_draw(surge::window::window_t w) noexcept -> int;
 
 SURGE_MODULE_EXPORT auto gl_update(surge::window::window_t w, double dt) noexcept -> int;
 
+SURGE_MODULE_EXPORT auto gl_build_update_graph(tf::Taskflow &graph,
+                                               surge::module::update_frame &frame) noexcept -> int;
+
 SURGE_MODULE_EXPORT void gl_keyboard_event(surge::window::window_t w, int key, int scancode,
                                            int action, int mods) noexcept;
 
@@ -1,8 +1,10 @@
 #include "sprite_demo.hpp"
 
+#include "sc_ecs.hpp"
 #include "sc_glm_includes.hpp"
 #include "sc_integer_types.hpp"
 #include "sc_logging.hpp"
+#include "sc_module.hpp"
 #include "sc_opengl/atoms/pv_ubo.hpp"
 #include "sc_opengl/atoms/sprite_database.hpp"
 #include "sc_opengl/atoms/texture.hpp"
@@ -20,8 +22,42 @@ static tdb_t tdb{};
 static sdb_t sdb{};
 static pv_ubo_t pv_ubo{};
 
+static surge::ecs::registry world{};
+
 } // namespace globals
 
+static const glm::vec2 original_bird_sheet_size{141.0f, 26.0f};
+
+static auto update_bird_flap_animation_frame(float delta_t) noexcept -> glm::vec4;
+
+static void spawn_birds() noexcept {
+  using namespace surge;
+
+  const auto first_frame{gl_atom::sprite_database::make_view(glm::vec4{1.0f, 1.0f, 34.0f, 24.0f},
+                                                             original_bird_sheet_size)};
+
+  const std::array<const char *, 3> textures{"resources/bird_red.png", "resources/bird_yellow.png",
+                                             "resources/bird_blue.png"};
+  const std::array<glm::vec2, 3> positions{glm::vec2{10.0f}, glm::vec2{120.0f}, glm::vec2{220.0f}};
+
+  for (usize i = 0; i < textures.size(); i++) {
+    const auto bird{globals::world.create()};
+    globals::world.emplace<ecs::transform>(bird, glm::vec3{positions[i], 0.1f},
+                                           glm::vec2{100.0f}, 0.0f);
+    globals::world.emplace<ecs::sprite>(bird, globals::tdb.find(textures[i]).value_or(0),
+                                        glm::vec4{1.0f}, first_frame);
+  }
+}
+
+static void flap(double delta_t) noexcept {
+  using namespace surge;
+
+  const auto frame{gl_atom::sprite_database::make_view(
+      update_bird_flap_animation_frame(static_cast<float>(delta_t)), original_bird_sheet_size)};
+  ecs::parallel_each<ecs::sprite>(globals::world,
+                                  [&](ecs::entity, ecs::sprite &s) { s.view = frame; });
+}
+
 extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) noexcept -> int {
   using namespace surge;
 
@@ -49,6 +85,7 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) noexce
     return static_cast<int>(sdb.error());
   } else {
     globals::sdb = *sdb;
+    gl_atom::sprite_database::begin_add(globals::sdb);
   }
 
   log_info("Loading resources");
@@ -58,6 +95,8 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_load(surge::window::window_t w) noexce
   globals::tdb.add(ci, "resources/bird_red.png", "resources/bird_yellow.png",
                    "resources/bird_blue.png");
 
+  spawn_birds();
+
   log_info("Sprite Demo module loaded");
   return 0;
 }
@@ -70,6 +109,8 @@ extern "C" SURGE_MODULE_EXPORT auto gl_on_unload(surge::window::window_t) noexce
   log_info("Waiting OpenGL idle");
   renderer::gl::wait_idle();
 
+  globals::world.clear();
+
   gl_atom::sprite_database::destroy(globals::sdb);
   globals::tdb.destroy();
 
@@ -84,10 +125,14 @@ extern "C" SURGE_MODULE_EXPORT auto gl_draw(surge::window::window_t) noexcept ->
   globals::pv_ubo.bind_to_location(2);
   gl_atom::sprite_database::draw(globals::sdb);
 
+  // Waits on a GL fence, so the next frame's buffer is claimed here, with the context current,
+  // instead of in the update tasks
+  gl_atom::sprite_database::begin_add(globals::sdb);
+
   return 0;
 }
 
-static inline auto update_bird_flap_animation_frame(float delta_t) noexcept -> glm::vec4 {
+static auto update_bird_flap_animation_frame(float delta_t) noexcept -> glm::vec4 {
   static const std::array<glm::vec4, 4> frame_views{
       glm::vec4{1.0f, 1.0f, 34.0f, 24.0f}, glm::vec4{36.0f, 1.0f, 34.0f, 24.0f},
       glm::vec4{71.0f, 1.0f, 34.0f, 24.0f}, glm::vec4{106.0f, 1.0f, 34.0f, 24.0f}};
@@ -109,27 +154,29 @@ static inline auto update_bird_flap_animation_frame(float delta_t) noexcept -> g
   return frame_views[frame_idx]; // NOLINT
 }
 
+// Only called if the update graph is empty, runs the same stages in order
 extern "C" SURGE_MODULE_EXPORT auto gl_update(surge::window::window_t, double delta_t) noexcept
     -> int {
   using namespace surge;
-  using namespace gl_atom::sprite_database;
 
-  static const auto r_texture{globals::tdb.find("resources/bird_red.png").value_or(0)};
-  static const auto y_texture{globals::tdb.find("resources/bird_yellow.png").value_or(0)};
-  static const auto b_texture{globals::tdb.find("resources/bird_blue.png").value_or(0)};
+  flap(delta_t);
+  ecs::feed_sprites(globals::world, globals::sdb);
 
-  static const glm::vec2 original_bird_sheet_size{141.0f, 26.0f};
+  return 0;
+}
+
+extern "C" SURGE_MODULE_EXPORT auto
+gl_build_update_graph(tf::Taskflow &graph, surge::module::update_frame &frame) noexcept -> int {
+  using namespace surge;
 
-  const auto flap_frame_view{update_bird_flap_animation_frame(static_cast<float>(delta_t))};
+  // Tasks make no GL calls, the write buffer was already claimed by the previous gl_draw
+  auto animate{graph.emplace([&frame]() { flap(frame.dt); })};
+  auto draw_sprites{graph.emplace([]() { ecs::feed_sprites(globals::world, globals::sdb); })};
 
-  begin_add(globals::sdb);
+  animate.name("flap");
+  draw_sprites.name("draw_sprites");
 
-  add_view(globals::sdb, r_texture, glm::vec2{10.0f}, glm::vec2{100.0f}, 0.1f, flap_frame_view,
-           original_bird_sheet_size);
-  add_view(globals::sdb, y_texture, glm::vec2{120.0f}, glm::vec2{100.0f}, 0.1f, flap_frame_view,
-           original_bird_sheet_size);
-  add_view(globals::sdb, b_texture, glm::vec2{220.0f}, glm::vec2{100.0f}, 0.1f, flap_frame_view,
-           original_bird_sheet_size);
+  animate.precede(draw_sprites);
 
   return 0;
 }
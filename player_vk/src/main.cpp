@@ -2,6 +2,7 @@
 #include "sc_cli.hpp"
 #include "sc_config.hpp"
 #include "sc_logging.hpp"
+#include "sc_memory_trace.hpp"
 #include "sc_module.hpp"
 #include "sc_options.hpp"
 #include "sc_tasks.hpp"
@@ -41,12 +42,14 @@ int main() {
      * Init allocators *
      *******************/
     allocators::mimalloc::init();
-    allocators::program_scope::init();
 
-    /**********************
-     * Init Task executor *
-     **********************/
-    tasks::executor::get();
+#ifdef SURGE_DEBUG_MEMORY
+    allocators::trace::start("memory_trace.smt");
+#endif
+
+    if (!allocators::program_scope::init()) {
+      return EXIT_FAILURE;
+    }
 
     /*********************
      * Parse config file *
@@ -56,7 +59,25 @@ int main() {
       return EXIT_FAILURE;
     }
 
-    const auto &[w_res, w_ccl, w_attrs, r_attrs, first_mod] = *config_data;
+    const auto &[w_res, w_ccl, w_attrs, r_attrs, first_mod, m_attrs, e_attrs] = *config_data;
+
+    /**********************
+     * Init Task executor *
+     **********************/
+    tasks::executor::configure(e_attrs);
+    tasks::executor::get();
+
+    /**********************
+     * Init engine arenas *
+     **********************/
+    if (m_attrs.arena_memory_size != 0) {
+      allocators::mimalloc::reserve_arena_memory(m_attrs.arena_memory_size, m_attrs.huge_pages);
+    }
+
+    if (!allocators::frame_scope::init(m_attrs.frame_arena_size, 2)) {
+      allocators::program_scope::destroy();
+      return EXIT_FAILURE;
+    }
 
     /***************
      * Init window *
@@ -104,7 +125,11 @@ int main() {
       return EXIT_FAILURE;
     }
 
-    auto on_load_result{mod_api->on_load(*engine_window, *vk_ctx)};
+    auto on_load_result{0};
+    {
+      const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+      on_load_result = mod_api->on_load(*engine_window, *vk_ctx);
+    }
     if (on_load_result != 0) {
       log_error("Mudule {} returned error {} while calling on_load", static_cast<void *>(*mod),
                 on_load_result);
@@ -116,6 +141,23 @@ int main() {
 
     module::bind_input_callbacks(*engine_window, *mod, *mod_api);
 
+    // Modules may describe their update as a task graph, built once and run every frame
+    tf::Taskflow update_graph{};
+    module::update_frame frame{};
+    frame.window = *engine_window;
+
+    if (module::build_update_graph(*mod_api, update_graph, frame, *vk_ctx).has_value()) {
+      module::unbind_input_callbacks(*engine_window);
+      {
+        const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+        mod_api->on_unload(*engine_window, *vk_ctx);
+      }
+      renderer::vk::terminate(*vk_ctx);
+      window::terminate(*engine_window);
+      module::unload(*mod);
+      return EXIT_FAILURE;
+    }
+
     /***********************
      * Main Loop variables *
      ***********************/
@@ -123,6 +165,11 @@ int main() {
     timers::generic_timer update_timer;
     update_timer.start();
 
+    // Frame deadline background jobs yield to, see tasks::yield_to_frame
+    // Uncapped or non positive caps budget for 60 Hz, so the budget is always finite
+    const auto frame_budget{
+        1.0 / (r_attrs.fps_cap && r_attrs.fps_cap_value > 0 ? r_attrs.fps_cap_value : 60)};
+
 #ifdef SURGE_ENABLE_HR
     auto hr_key_old_state{window::get_key(*engine_window, GLFW_KEY_F5)
                           && window::get_key(*engine_window, GLFW_KEY_LEFT_CONTROL)};
@@ -132,8 +179,20 @@ int main() {
      * Main Loop *
      *************/
     while ((frame_timer.start(), !window::should_close(*engine_window))) {
-      // Event handling
-      window::poll_events();
+      tasks::begin_frame(frame_budget);
+
+      // Recycle transient frame memory
+      allocators::frame_scope::advance();
+
+#ifdef SURGE_DEBUG_MEMORY
+      allocators::trace::flush();
+#endif
+
+      // Event handling. Input callbacks call into the module
+      {
+        const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+        window::poll_events();
+      }
 
       // Handle hot reloading
 #ifdef SURGE_ENABLE_HR
@@ -145,7 +204,11 @@ int main() {
         t.start();
 
         module::unbind_input_callbacks(*engine_window);
-        mod_api->on_unload(*engine_window, *vk_ctx);
+        update_graph.clear();
+        {
+          const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+          mod_api->on_unload(*engine_window, *vk_ctx);
+        }
 
         mod = module::reload(*mod);
         if (!mod) {
@@ -157,7 +220,10 @@ int main() {
           break;
         }
 
-        on_load_result = mod_api->on_load(*engine_window, *vk_ctx);
+        {
+          const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+          on_load_result = mod_api->on_load(*engine_window, *vk_ctx);
+        }
         if (on_load_result != 0) {
           log_error("Mudule {} returned error {} while calling on_load", static_cast<void *>(*mod),
                     on_load_result);
@@ -166,6 +232,10 @@ int main() {
 
         module::bind_input_callbacks(*engine_window, *mod, *mod_api);
 
+        if (module::build_update_graph(*mod_api, update_graph, frame, *vk_ctx).has_value()) {
+          break;
+        }
+
         t.stop();
         log_info("Hot reloading succsesfull in {} s", t.elapsed());
       }
@@ -202,8 +272,20 @@ int main() {
     && defined(SURGE_ENABLE_TRACY)
         ZoneScopedN("Update");
 #endif
-        if (mod_api->update(*engine_window, *vk_ctx, update_timer.stop()) != 0) {
-          window::set_should_close(*engine_window, true);
+        const auto dt{update_timer.stop()};
+
+        if (update_graph.empty()) {
+          const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+          if (mod_api->update(*engine_window, *vk_ctx, dt) != 0) {
+            window::set_should_close(*engine_window, true);
+          }
+        } else {
+          // Joined here, so draw always sees a finished update
+          frame.dt = dt;
+          tasks::executor::get().run(update_graph).wait();
+          if (frame.status.exchange(0) != 0) {
+            window::set_should_close(*engine_window, true);
+          }
         }
       }
       update_timer.start();
@@ -214,6 +296,7 @@ int main() {
     && defined(SURGE_ENABLE_TRACY)
         ZoneScopedN("Draw");
 #endif
+        const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
         mod_api->draw(*engine_window, *vk_ctx);
       }
 
@@ -248,6 +331,9 @@ int main() {
         }
       }
 
+      // Background jobs may use the cores freely until the next frame starts
+      tasks::end_frame();
+
       // Refresh HR key state
 #ifdef SURGE_ENABLE_HR
       hr_key_old_state = window::get_key(*engine_window, GLFW_KEY_F5)
@@ -255,7 +341,7 @@ int main() {
 #endif
 
       // FPS Cap.
-      if (r_attrs.fps_cap) {
+      if (r_attrs.fps_cap && r_attrs.fps_cap_value > 0) {
         while (frame_timer.since_start() < (1.0 / r_attrs.fps_cap_value)) {
           // Spin wait
         }
@@ -273,7 +359,11 @@ int main() {
      * Finalize modules *
      ********************/
     module::unbind_input_callbacks(*engine_window);
-    mod_api->on_unload(*engine_window, *vk_ctx);
+    update_graph.clear();
+    {
+      const allocators::mimalloc::heap_scope mod_heap{module::get_heap(*mod)};
+      mod_api->on_unload(*engine_window, *vk_ctx);
+    }
     module::unload(*mod);
 
     /********************************
@@ -286,8 +376,13 @@ int main() {
     /***********************
      * Finalize allocators *
      ***********************/
+    allocators::frame_scope::destroy();
     allocators::program_scope::destroy();
 
+#ifdef SURGE_DEBUG_MEMORY
+    allocators::trace::stop();
+#endif
+
 #if (defined(SURGE_BUILD_TYPE_Profile) || defined(SURGE_BUILD_TYPE_RelWithDebInfo))                \
     && defined(SURGE_ENABLE_TRACY)
     log_info("Tracy may still be collecting profiling data. Please wait...");
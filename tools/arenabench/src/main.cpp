@@ -0,0 +1,147 @@
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_timers.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <mimalloc.h>
+#include <random>
+#include <string_view>
+
+using namespace surge;
+
+/*
+ * Compares the bump allocator in mimalloc::arena with mi_malloc_aligned on frame scratch shaped
+ * workloads. Each frame makes the same list of requests, the arena is reset and every mimalloc
+ * block is freed at the end of the frame. Throughput counts allocations only, the best of N frames
+ * is kept. Fragmentation is the share of the bytes handed out that were not requested: alignment
+ * padding for the arena, size class rounding for mimalloc. A checksum of the returned pointers is
+ * printed so the allocations cannot be optimized out.
+ */
+
+struct request {
+  usize size{0};
+  usize alignment{0};
+};
+
+struct result {
+  double best_s{1.0e30};
+  double fragmentation{0};
+  u64 checksum{0};
+};
+
+static auto bench_arena(usize repetitions, const vector<request> &requests) -> result {
+  usize capacity{0};
+  for (const auto &r : requests) {
+    capacity += r.size + r.alignment;
+  }
+
+  allocators::mimalloc::arena a{capacity};
+  result res{};
+
+  for (usize i = 0; i < repetitions; i++) {
+    a.reset();
+
+    timers::generic_timer t{};
+    t.start();
+    for (const auto &r : requests) {
+      auto p{static_cast<std::byte *>(a.allocate(r.size, r.alignment))};
+      *p = std::byte{1};
+      res.checksum += reinterpret_cast<std::uintptr_t>(p) & 0xff; // NOLINT
+    }
+    const auto elapsed{t.stop()};
+
+    if (elapsed < res.best_s) {
+      res.best_s = elapsed;
+    }
+  }
+
+  res.fragmentation = static_cast<double>(a.wasted()) / static_cast<double>(a.size());
+  return res;
+}
+
+static auto bench_mimalloc(usize repetitions, const vector<request> &requests) -> result {
+  vector<void *> blocks(requests.size());
+  result res{};
+
+  usize requested{0};
+  usize usable{0};
+
+  for (usize i = 0; i < repetitions; i++) {
+    timers::generic_timer t{};
+    t.start();
+    for (usize j = 0; j < requests.size(); j++) {
+      auto p{static_cast<std::byte *>(mi_malloc_aligned(requests[j].size, requests[j].alignment))};
+      *p = std::byte{1};
+      res.checksum += reinterpret_cast<std::uintptr_t>(p) & 0xff; // NOLINT
+      blocks[j] = p;
+    }
+    const auto elapsed{t.stop()};
+
+    if (elapsed < res.best_s) {
+      res.best_s = elapsed;
+    }
+
+    for (usize j = 0; j < requests.size(); j++) {
+      if (i == 0) {
+        requested += requests[j].size;
+        usable += mi_usable_size(blocks[j]);
+      }
+      mi_free(blocks[j]);
+    }
+  }
+
+  res.fragmentation = static_cast<double>(usable - requested) / static_cast<double>(usable);
+  return res;
+}
+
+static void print_result(std::string_view workload, std::string_view allocator, const result &r,
+                         usize allocations) {
+  fmt::print("{:<16} {:<10} {:>10.2f} M allocs/s {:>8.2f} % wasted  (checksum {})\n", workload,
+             allocator, static_cast<double>(allocations) / r.best_s * 1.0e-6,
+             r.fragmentation * 100.0, r.checksum);
+}
+
+static auto make_requests(std::mt19937 &rng, usize count, usize min_size, usize max_size,
+                          std::span<const usize> alignments) -> vector<request> {
+  std::uniform_int_distribution<usize> size{min_size, max_size};
+  std::uniform_int_distribution<usize> alignment{0, alignments.size() - 1};
+
+  vector<request> requests(count);
+  for (auto &r : requests) {
+    r.size = size(rng);
+    r.alignment = alignments[alignment(rng)];
+  }
+  return requests;
+}
+
+auto main(int argc, char **argv) -> int {
+  allocators::mimalloc::init();
+
+  const auto repetitions{argc > 1 ? static_cast<usize>(std::strtoull(argv[1], nullptr, 10)) : 10};
+
+  fmt::print("Best of {} frames\n", repetitions);
+
+  std::mt19937 rng{1234};
+
+  constexpr std::array<usize, 1> word{8};
+  constexpr std::array<usize, 4> mixed{8, 16, 32, 64};
+  constexpr std::array<usize, 1> cache_line{64};
+
+  const auto uniform{make_requests(rng, 1 << 14, 16, 16, word)};
+  const auto scratch{make_requests(rng, 1 << 14, 8, 256, mixed)};
+  const auto simd{make_requests(rng, 1 << 12, 64, 4096, cache_line)};
+
+  print_result("uniform 16 B", "arena", bench_arena(repetitions, uniform), uniform.size());
+  print_result("uniform 16 B", "mi_malloc", bench_mimalloc(repetitions, uniform), uniform.size());
+
+  print_result("mixed scratch", "arena", bench_arena(repetitions, scratch), scratch.size());
+  print_result("mixed scratch", "mi_malloc", bench_mimalloc(repetitions, scratch), scratch.size());
+
+  print_result("simd buffers", "arena", bench_arena(repetitions, simd), simd.size());
+  print_result("simd buffers", "mi_malloc", bench_mimalloc(repetitions, simd), simd.size());
+
+  return EXIT_SUCCESS;
+}
\ No newline at end of file
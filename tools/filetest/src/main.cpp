@@ -0,0 +1,153 @@
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_files.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_timers.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/core.h>
+#include <fstream>
+#include <string_view>
+
+using namespace surge;
+
+/*
+ * Checks load_file on files whose sizes stress the read paths. Each file is read with cached and
+ * direct IO, with and without the appended null byte. Sizes are not multiples of the direct IO
+ * block size, so the last direct read is short, and the large file is past 4 GiB, so sizes and
+ * offsets need more than 32 bits. The large file is sparse: only a few marker bytes are written,
+ * at both sides of the 2 GiB and 4 GiB boundaries, and everything else reads as zeros. Reading it
+ * still needs a buffer of over 4 GiB. Files are created in the given directory, the system temp
+ * directory by default, and removed at the end.
+ */
+
+struct marker {
+  u64 offset{0};
+  std::byte value{0};
+};
+
+struct test_file {
+  std::string_view name{};
+  u64 size{0};
+  vector<marker> markers{};
+};
+
+static auto make_test_file(const test_file &tf, const std::filesystem::path &path) -> bool {
+  {
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    if (!out) {
+      return false;
+    }
+  }
+
+  // Resizing leaves a hole, which takes no disk space on file systems with sparse files
+  std::error_code ec{};
+  std::filesystem::resize_file(path, tf.size, ec);
+  if (ec) {
+    fmt::print("Unable to resize {}: {}\n", path.string(), ec.message());
+    return false;
+  }
+
+  std::fstream out{path, std::ios::binary | std::ios::in | std::ios::out};
+  for (const auto &m : tf.markers) {
+    out.seekp(static_cast<std::streamoff>(m.offset));
+    out.write(reinterpret_cast<const char *>(&m.value), 1); // NOLINT
+  }
+
+  return static_cast<bool>(out);
+}
+
+static auto check_contents(const test_file &tf, const files::file_data_t &data,
+                           bool append_null_byte) -> bool {
+  if (data.size() != (append_null_byte ? tf.size + 1 : tf.size)) {
+    fmt::print("  expected {} bytes, got {}\n", append_null_byte ? tf.size + 1 : tf.size,
+               data.size());
+    return false;
+  }
+
+  if (append_null_byte && data.back() != std::byte{0}) {
+    fmt::print("  the appended byte is not null\n");
+    return false;
+  }
+
+  for (const auto &m : tf.markers) {
+    if (data[m.offset] != m.value) {
+      fmt::print("  wrong byte at offset {}\n", m.offset);
+      return false;
+    }
+  }
+
+  // Markers are the only non zero bytes, so a misplaced chunk shows up in the count
+  const auto non_zero{static_cast<usize>(
+      std::count_if(data.begin(), data.end(), [](std::byte b) { return b != std::byte{0}; }))};
+  if (non_zero != tf.markers.size()) {
+    fmt::print("  expected {} non zero bytes, got {}\n", tf.markers.size(), non_zero);
+    return false;
+  }
+
+  return true;
+}
+
+static auto run_test(const test_file &tf, const std::filesystem::path &dir) -> bool {
+  const auto path{dir / fmt::format("surge_filetest_{}.bin", tf.name)};
+
+  if (!make_test_file(tf, path)) {
+    fmt::print("Unable to create {}\n", path.string());
+    return false;
+  }
+
+  bool ok{true};
+
+  for (const auto mode : {files::io_mode::cached, files::io_mode::direct}) {
+    for (const bool append_null_byte : {false, true}) {
+      const auto mode_name{mode == files::io_mode::cached ? "cached" : "direct"};
+
+      timers::generic_timer t{};
+      t.start();
+      const auto data{files::load_file(path.string().c_str(), append_null_byte, mode)};
+      const auto elapsed{t.stop()};
+
+      const bool passed{data && check_contents(tf, *data, append_null_byte)};
+      fmt::print("{:<6} {:>12} B {:<6} {:<14} {} ({:.2f} s)\n", tf.name, tf.size, mode_name,
+                 append_null_byte ? "null appended" : "as is", passed ? "PASS" : "FAIL", elapsed);
+      ok = ok && passed;
+    }
+  }
+
+  std::error_code ec{};
+  std::filesystem::remove(path, ec);
+
+  return ok;
+}
+
+auto main(int argc, char **argv) -> int {
+  allocators::mimalloc::init();
+
+  const auto dir{argc > 1 ? std::filesystem::path{argv[1]}
+                          : std::filesystem::temp_directory_path()};
+
+  constexpr u64 gib{u64{1} << 30};
+
+  // Three blocks and a partial one
+  const test_file small{"small",
+                        3 * 4096 + 123,
+                        {{0, std::byte{1}}, {3 * 4096 + 122, std::byte{2}}}};
+
+  const test_file large{"large",
+                        4 * gib + 4096 + 77,
+                        {{0, std::byte{1}},
+                         {2 * gib - 1, std::byte{2}},
+                         {2 * gib, std::byte{3}},
+                         {4 * gib - 1, std::byte{4}},
+                         {4 * gib, std::byte{5}},
+                         {4 * gib + 4096 + 76, std::byte{6}}}};
+
+  bool ok{true};
+  ok = run_test(small, dir) && ok;
+  ok = run_test(large, dir) && ok;
+
+  fmt::print("{}\n", ok ? "All reads passed" : "Some reads failed");
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
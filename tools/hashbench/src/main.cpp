@@ -0,0 +1,150 @@
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_timers.hpp"
+
+#include <cstdlib>
+#include <fmt/core.h>
+#include <random>
+#include <string_view>
+
+using namespace surge;
+
+/*
+ * Compares surge::hash_map against the node based map it replaced, on workloads shaped like the
+ * engine's glyph caches and texture name lookups. Each workload is repeated and the best time is
+ * kept, and a checksum of the looked up values is printed so the lookups cannot be optimized out.
+ */
+
+struct result {
+  double best_s{1.0e30};
+  u64 checksum{0};
+};
+
+template <typename F> static auto measure(usize repetitions, F &&f) -> result {
+  result r{};
+  for (usize i = 0; i < repetitions; i++) {
+    timers::generic_timer t{};
+    t.start();
+    r.checksum += f();
+    const auto elapsed{t.stop()};
+    if (elapsed < r.best_s) {
+      r.best_s = elapsed;
+    }
+  }
+  return r;
+}
+
+static void print_result(std::string_view workload, std::string_view map_name, const result &r,
+                         usize operations) {
+  fmt::print("{:<22} {:<14} {:>10.3f} ms {:>8.2f} ns/op  (checksum {})\n", workload, map_name,
+             r.best_s * 1.0e3, r.best_s * 1.0e9 / static_cast<double>(operations), r.checksum);
+}
+
+/*
+ * Glyph cache: the four codepoint keyed maps of gl_atom::text::glyph_cache that are read while
+ * laying out text, and a stream of characters looked up the way text_buffer::push does, with a
+ * membership test followed by one lookup per attribute.
+ */
+template <template <typename, typename> typename Map>
+static auto glyph_cache_workload(const vector<u32> &text) -> u64 {
+  Map<u32, u64> handles{};
+  Map<u32, u32> dims{};
+  Map<u32, i32> bearings{};
+  Map<u32, i64> advances{};
+
+  for (u32 c = 0; c < 128; c++) {
+    handles[c] = c * 3;
+    dims[c] = c * 5;
+    bearings[c] = static_cast<i32>(c);
+    advances[c] = static_cast<i64>(c) * 64;
+  }
+  handles[0xFFFD] = 1;
+  dims[0xFFFD] = 1;
+  bearings[0xFFFD] = 1;
+  advances[0xFFFD] = 1;
+
+  u64 sum{0};
+  for (auto c : text) {
+    if (!handles.contains(c)) {
+      c = 0xFFFD;
+    }
+    sum += handles.at(c) + dims.at(c) + static_cast<u64>(bearings.at(c))
+           + static_cast<u64>(advances.at(c));
+  }
+  return sum;
+}
+
+/*
+ * Texture names: filling a name keyed table and looking names up from const char * queries. Both
+ * maps use the transparent string hash, so neither builds a temporary key.
+ */
+template <template <typename, typename> typename Map>
+static auto texture_name_workload(const vector<string> &names, const vector<const char *> &queries)
+    -> u64 {
+  Map<string, u64> table{};
+  table.reserve(names.size());
+  for (usize i = 0; i < names.size(); i++) {
+    table[names[i]] = i;
+  }
+
+  u64 sum{0};
+  for (const auto query : queries) {
+    const auto it{table.find(std::string_view{query})};
+    sum += it != table.end() ? it->second : 0;
+  }
+  return sum;
+}
+
+auto main(int argc, char **argv) -> int {
+  allocators::mimalloc::init();
+
+  const auto repetitions{argc > 1 ? static_cast<usize>(std::strtoull(argv[1], nullptr, 10)) : 10};
+
+  std::mt19937 rng{1234};
+
+  // Mostly printable ASCII with the odd codepoint missing from the cache
+  constexpr usize text_size{1 << 20};
+  vector<u32> text{};
+  text.reserve(text_size);
+  std::uniform_int_distribution<u32> printable{32, 126};
+  std::uniform_int_distribution<u32> percent{0, 99};
+  for (usize i = 0; i < text_size; i++) {
+    text.push_back(percent(rng) == 0 ? 0x00E9 : printable(rng));
+  }
+
+  constexpr usize texture_count{512};
+  constexpr usize query_count{1 << 18};
+  vector<string> names{};
+  names.reserve(texture_count);
+  for (usize i = 0; i < texture_count; i++) {
+    names.push_back(string{fmt::format("resources/textures/tile_{:04}.png", i).c_str()});
+  }
+
+  vector<const char *> queries{};
+  queries.reserve(query_count);
+  std::uniform_int_distribution<usize> name_idx{0, texture_count - 1};
+  for (usize i = 0; i < query_count; i++) {
+    queries.push_back(names[name_idx(rng)].c_str());
+  }
+
+  fmt::print("Best of {} runs\n", repetitions);
+
+  print_result("glyph cache", "hash_map",
+               measure(repetitions, [&] { return glyph_cache_workload<hash_map>(text); }),
+               text_size);
+  print_result("glyph cache", "node_hash_map",
+               measure(repetitions, [&] { return glyph_cache_workload<node_hash_map>(text); }),
+               text_size);
+
+  print_result(
+      "texture names", "hash_map",
+      measure(repetitions, [&] { return texture_name_workload<hash_map>(names, queries); }),
+      query_count);
+  print_result(
+      "texture names", "node_hash_map",
+      measure(repetitions, [&] { return texture_name_workload<node_hash_map>(names, queries); }),
+      query_count);
+
+  return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_error_types.hpp"
+#include "sc_logging.hpp"
+#include "sc_memory_trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fmt/core.h>
+#include <string_view>
+#include <tl/expected.hpp>
+
+using namespace surge;
+using allocators::accounting::tag;
+using allocators::accounting::tag_count;
+using allocators::accounting::tag_name;
+using allocators::trace::op;
+using allocators::trace::record;
+
+struct live_allocation {
+  u64 size{0};
+  u64 timestamp{0};
+  u32 thread{0};
+  tag allocation_tag{tag::general};
+};
+
+/*
+ * Replays trace records to rebuild the live heap. Realloc moves are recorded as a free followed by
+ * an alloc. Frees are recorded before the memory is released, so an address is only reused after
+ * its free, but the free may have been lost to a ring buffer overflow. An alloc on a live address
+ * therefore implicitly retires the previous allocation.
+ */
+struct heap_state {
+  hash_map<u64, live_allocation> live{};
+  array<u64, tag_count> live_bytes{};
+  array<i64, tag_count> internal_bytes{};
+  u64 arena_allocs{0};
+  u64 arena_resets{0};
+  u64 unmatched_frees{0};
+  u64 dropped_events{0};
+
+  void apply(const record &r) {
+    const auto t{static_cast<usize>(r.tag)};
+
+    switch (r.operation) {
+    case op::alloc: {
+      if (const auto it{live.find(r.address)}; it != live.end()) {
+        live_bytes[static_cast<usize>(it->second.allocation_tag)] -= it->second.size;
+      }
+      live[r.address] = live_allocation{r.size, r.timestamp, r.thread, r.tag};
+      live_bytes[t] += r.size;
+      break;
+    }
+
+    case op::free: {
+      const auto it{live.find(r.address)};
+      if (it == live.end()) {
+        unmatched_frees++;
+      } else {
+        live_bytes[static_cast<usize>(it->second.allocation_tag)] -= it->second.size;
+        live.erase(it);
+      }
+      break;
+    }
+
+    case op::arena_alloc:
+      arena_allocs++;
+      break;
+
+    case op::arena_reset:
+      arena_resets++;
+      break;
+
+    case op::internal_alloc:
+      internal_bytes[t] += static_cast<i64>(r.size);
+      break;
+
+    case op::internal_free:
+      internal_bytes[t] -= static_cast<i64>(r.size);
+      break;
+
+    case op::dropped:
+      dropped_events += r.size;
+      break;
+    }
+  }
+
+  [[nodiscard]] auto total_live_bytes() const -> u64 {
+    u64 total{0};
+    for (const auto bytes : live_bytes) {
+      total += bytes;
+    }
+    return total;
+  }
+};
+
+static auto read_trace(const char *path) -> tl::expected<vector<record>, error> {
+  // NOLINTNEXTLINE
+  auto file{std::fopen(path, "rb")};
+
+  if (file == nullptr) {
+    log_error("Unable to open {}", path);
+    return tl::unexpected{error::invalid_path};
+  }
+
+  allocators::trace::file_header header{};
+  const allocators::trace::file_header expected_header{};
+
+  if (std::fread(&header, sizeof(header), 1, file) != 1
+      || std::memcmp(header.magic, expected_header.magic, sizeof(header.magic)) != 0
+      || header.version != expected_header.version || header.record_size != sizeof(record)) {
+    log_error("{} is not a memory trace this tool understands", path);
+    std::fclose(file);
+    return tl::unexpected{error::invalid_format};
+  }
+
+  vector<record> records{};
+  array<record, 4096> buffer{};
+
+  usize count{0};
+  while ((count = std::fread(buffer.data(), sizeof(record), buffer.size(), file)) != 0) {
+    records.insert(records.end(), buffer.begin(), buffer.begin() + static_cast<long>(count));
+  }
+
+  std::fclose(file);
+
+  // Records from different threads are flushed in claim order, not in timestamp order
+  std::stable_sort(records.begin(), records.end(), [](const record &a, const record &b) {
+    return a.timestamp < b.timestamp;
+  });
+
+  return records;
+}
+
+static void print_warnings(const heap_state &heap) {
+  if (heap.dropped_events != 0) {
+    fmt::print("warning: {} events were dropped while recording. Results may be inaccurate\n",
+               heap.dropped_events);
+  }
+
+  if (heap.unmatched_frees != 0) {
+    fmt::print("warning: {} frees did not match a recorded allocation\n", heap.unmatched_frees);
+  }
+}
+
+static void print_timeline(const vector<record> &records, u64 bucket_ms) {
+  const auto bucket_ns{bucket_ms * 1000000};
+
+  fmt::print("time_s,total_bytes");
+  for (usize i = 0; i < tag_count; i++) {
+    fmt::print(",{}_bytes", tag_name(static_cast<tag>(i)));
+  }
+  fmt::print(",vulkan_internal_bytes,arena_allocs\n");
+
+  heap_state heap{};
+  u64 bucket_arena_allocs{0};
+
+  const auto print_row{[&](u64 bucket) {
+    fmt::print("{:.3f},{}", static_cast<double>(bucket * bucket_ns) / 1.0e9,
+               heap.total_live_bytes());
+    for (const auto bytes : heap.live_bytes) {
+      fmt::print(",{}", bytes);
+    }
+    fmt::print(",{},{}\n", heap.internal_bytes[static_cast<usize>(tag::vulkan)],
+               heap.arena_allocs - bucket_arena_allocs);
+    bucket_arena_allocs = heap.arena_allocs;
+  }};
+
+  u64 current_bucket{0};
+
+  for (const auto &r : records) {
+    const auto bucket{r.timestamp / bucket_ns};
+
+    while (current_bucket < bucket) {
+      print_row(current_bucket);
+      current_bucket++;
+    }
+
+    heap.apply(r);
+  }
+
+  print_row(current_bucket);
+  print_warnings(heap);
+}
+
+static void print_leaks(const vector<record> &records, usize max_entries) {
+  heap_state heap{};
+  for (const auto &r : records) {
+    heap.apply(r);
+  }
+
+  fmt::print("{} allocations totaling {} B were never freed\n\n", heap.live.size(),
+             heap.total_live_bytes());
+
+  array<u64, tag_count> leak_counts{};
+  for (const auto &[address, allocation] : heap.live) {
+    leak_counts[static_cast<usize>(allocation.allocation_tag)]++;
+  }
+
+  fmt::print("{:<10} {:>12} {:>16}\n", "tag", "allocations", "bytes");
+  for (usize i = 0; i < tag_count; i++) {
+    if (leak_counts[i] != 0) {
+      fmt::print("{:<10} {:>12} {:>16}\n", tag_name(static_cast<tag>(i)), leak_counts[i],
+                 heap.live_bytes[i]);
+    }
+  }
+
+  vector<std::pair<u64, live_allocation>> largest(heap.live.begin(), heap.live.end());
+  std::sort(largest.begin(), largest.end(),
+            [](const auto &a, const auto &b) { return a.second.size > b.second.size; });
+
+  if (largest.size() > max_entries) {
+    largest.resize(max_entries);
+  }
+
+  if (!largest.empty()) {
+    fmt::print("\n{:<20} {:>12} {:<10} {:>10} {:>12}\n", "address", "bytes", "tag", "thread",
+               "time_s");
+  }
+
+  for (const auto &[address, allocation] : largest) {
+    fmt::print("{:<#20x} {:>12} {:<10} {:>10} {:>12.3f}\n", address, allocation.size,
+               tag_name(allocation.allocation_tag), allocation.thread,
+               static_cast<double>(allocation.timestamp) / 1.0e9);
+  }
+
+  fmt::print("\n{} arena allocations, {} arena resets\n", heap.arena_allocs, heap.arena_resets);
+  print_warnings(heap);
+}
+
+static void print_usage() {
+  fmt::print("Usage:\n"
+             "  surge_memtrace timeline <trace file> [bucket size in ms, default 100]\n"
+             "  surge_memtrace leaks <trace file> [max listed allocations, default 20]\n");
+}
+
+auto main(int argc, char **argv) -> int {
+  if (argc < 3) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const std::string_view command{argv[1]};
+
+  if (command != "timeline" && command != "leaks") {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const auto records{read_trace(argv[2])};
+  if (!records) {
+    return EXIT_FAILURE;
+  }
+
+  if (command == "timeline") {
+    const auto bucket_ms{argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100};
+    print_timeline(*records, bucket_ms == 0 ? 1 : bucket_ms);
+  } else {
+    const auto max_entries{argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 20};
+    print_leaks(*records, static_cast<usize>(max_entries));
+  }
+
+  return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,459 @@
+#include "sc_allocators.hpp"
+#include "sc_archive.hpp"
+#include "sc_container_types.hpp"
+#include "sc_files.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_logging.hpp"
+#include "sc_tasks.hpp"
+#include "sc_timers.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fmt/core.h>
+#include <optional>
+#include <string_view>
+
+using namespace surge;
+using files::archive_entry;
+using files::archive_header;
+using files::compression;
+
+/*
+ * Builds, lists and benchmarks SURGE asset packs. Entries are named after the path of each input
+ * file, relative to the working directory, lexically normalized and with / separators. That is the
+ * path the engine must use to find them, so packs are best built from the directory the game runs
+ * from.
+ */
+
+struct pack_input {
+  string name{};
+  std::filesystem::path path{};
+  u64 size{0};
+  u64 hash{0};
+  compression method{compression::none};
+};
+
+struct pack_options {
+  u32 alignment{64};
+  u32 chunk_size{files::default_chunk_size};
+};
+
+static auto align_up(u64 value, u64 alignment) -> u64 {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+static auto parse_compression(std::string_view name) -> std::optional<compression> {
+  if (name == "none") {
+    return compression::none;
+  } else if (name == "lz4") {
+    return compression::lz4;
+  } else if (name == "zstd") {
+    return compression::zstd;
+  } else {
+    return {};
+  }
+}
+
+static auto compression_name(compression method) -> std::string_view {
+  switch (method) {
+  case compression::none:
+    return "none";
+  case compression::lz4:
+    return "lz4";
+  case compression::zstd:
+    return "zstd";
+  default:
+    return "unknown";
+  }
+}
+
+static void add_input(vector<pack_input> &inputs, const std::filesystem::path &p,
+                      compression method) {
+  const auto normal{p.lexically_normal().generic_string()};
+  const auto size{static_cast<u64>(std::filesystem::file_size(p))};
+  inputs.push_back(pack_input{string{normal.data(), normal.size()}, p, size, 0, method});
+  inputs.back().hash = files::archive_hash(inputs.back().name);
+}
+
+static auto collect_input(vector<pack_input> &inputs, const char *arg, compression method)
+    -> bool {
+  try {
+    const std::filesystem::path p{arg};
+
+    if (std::filesystem::is_directory(p)) {
+      // Sorted, so the same tree always produces the same pack
+      vector<std::filesystem::path> files{};
+      for (const auto &e : std::filesystem::recursive_directory_iterator{p}) {
+        if (e.is_regular_file()) {
+          files.push_back(e.path());
+        }
+      }
+      std::sort(files.begin(), files.end());
+
+      for (const auto &f : files) {
+        add_input(inputs, f, method);
+      }
+    } else if (std::filesystem::is_regular_file(p)) {
+      add_input(inputs, p, method);
+    } else {
+      log_error("{} is not a file or directory", arg);
+      return false;
+    }
+  } catch (const std::exception &e) {
+    log_error("Unable to collect the pack inputs: {}", e.what());
+    return false;
+  }
+
+  return true;
+}
+
+// Appends the contents of path to out, checking that the file still has the expected size
+static auto copy_file(std::FILE *out, const pack_input &in, vector<std::byte> &buffer) -> bool {
+  // NOLINTNEXTLINE
+  auto file{std::fopen(in.path.string().c_str(), "rb")};
+  if (file == nullptr) {
+    log_error("Unable to open {}", in.name);
+    return false;
+  }
+
+  u64 copied{0};
+  while (true) {
+    const auto n{std::fread(buffer.data(), 1, buffer.size(), file)};
+    if (n == 0) {
+      break;
+    }
+
+    if (std::fwrite(buffer.data(), 1, n, out) != n) {
+      log_error("Unable to write the contents of {}", in.name);
+      std::fclose(file);
+      return false;
+    }
+    copied += n;
+  }
+
+  std::fclose(file);
+
+  if (copied != in.size) {
+    log_error("{} changed size while being packed", in.name);
+    return false;
+  }
+
+  return true;
+}
+
+static auto write_padding(std::FILE *out, u64 count) -> bool {
+  static constexpr array<std::byte, 4096> zeros{};
+  while (count > 0) {
+    const auto n{std::min(count, static_cast<u64>(zeros.size()))};
+    if (std::fwrite(zeros.data(), 1, n, out) != n) {
+      return false;
+    }
+    count -= n;
+  }
+  return true;
+}
+
+/*
+ * Writes the payload of in at the current position of out and fills its entry. Compressed inputs
+ * that do not get smaller are stored as they are.
+ */
+static auto write_payload(std::FILE *out, const pack_input &in, const pack_options &opts,
+                          archive_entry &entry, vector<std::byte> &buffer) -> bool {
+  entry.size = in.size;
+  entry.stored_size = in.size;
+  entry.method = compression::none;
+  entry.chunk_size = 0;
+
+  if (in.method == compression::none || in.size == 0) {
+    return copy_file(out, in, buffer);
+  }
+
+  const auto contents{files::load_file(in.path.string().c_str(), false)};
+  if (!contents || contents->size() != in.size) {
+    log_error("Unable to read {}", in.name);
+    return false;
+  }
+
+  const auto payload{files::compress_payload(in.method, opts.chunk_size, *contents)};
+  if (!payload) {
+    log_error("Unable to compress {}", in.name);
+    return false;
+  }
+
+  if (payload->size() >= contents->size()) {
+    return std::fwrite(contents->data(), 1, contents->size(), out) == contents->size();
+  }
+
+  entry.stored_size = payload->size();
+  entry.method = in.method;
+  entry.chunk_size = opts.chunk_size;
+  return std::fwrite(payload->data(), 1, payload->size(), out) == payload->size();
+}
+
+static auto create_pack(const char *pack_path, const pack_options &opts,
+                        vector<pack_input> &inputs) -> bool {
+  // The index is sorted by hash, the payloads keep the input order so related assets stay close
+  vector<usize> by_hash(inputs.size());
+  for (usize i = 0; i < by_hash.size(); i++) {
+    by_hash[i] = i;
+  }
+  std::sort(by_hash.begin(), by_hash.end(),
+            [&](usize a, usize b) { return inputs[a].hash < inputs[b].hash; });
+
+  for (usize i = 1; i < by_hash.size(); i++) {
+    const auto &a{inputs[by_hash[i - 1]]};
+    const auto &b{inputs[by_hash[i]]};
+    if (a.hash == b.hash) {
+      log_error("{} and {} have the same name hash", a.name, b.name);
+      return false;
+    }
+  }
+
+  // Layout
+  archive_header header{};
+  header.entry_count = inputs.size();
+  header.index_offset = align_up(sizeof(archive_header), alignof(archive_entry));
+  header.names_offset = header.index_offset + inputs.size() * sizeof(archive_entry);
+  header.alignment = opts.alignment;
+
+  vector<archive_entry> entries(inputs.size());
+  u64 names_size{0};
+  for (usize i = 0; i < inputs.size(); i++) {
+    entries[i].name_hash = inputs[i].hash;
+    entries[i].name_offset = static_cast<u32>(names_size);
+    entries[i].name_length = static_cast<u32>(inputs[i].name.size());
+    names_size += inputs[i].name.size();
+  }
+
+  // NOLINTNEXTLINE
+  auto out{std::fopen(pack_path, "wb")};
+  if (out == nullptr) {
+    log_error("Unable to create {}", pack_path);
+    return false;
+  }
+
+  // Stored sizes are only known once payloads are compressed, so the payloads are written first
+  // and the header, index and names go in the space left before them
+  auto position{align_up(header.names_offset + names_size, opts.alignment)};
+  bool ok{write_padding(out, position)};
+
+  vector<std::byte> buffer(1024 * 1024);
+  u64 total_size{0};
+
+  for (usize i = 0; i < inputs.size() && ok; i++) {
+    entries[i].offset = position;
+    ok = write_payload(out, inputs[i], opts, entries[i], buffer);
+
+    const auto next{align_up(position + entries[i].stored_size, opts.alignment)};
+    ok = ok && write_padding(out, next - position - entries[i].stored_size);
+    position = next;
+    total_size += entries[i].size;
+  }
+
+  ok = ok && std::fseek(out, 0, SEEK_SET) == 0;
+  ok = ok && std::fwrite(&header, sizeof(header), 1, out) == 1;
+  ok = ok && write_padding(out, header.index_offset - sizeof(header));
+
+  for (const auto i : by_hash) {
+    ok = ok && std::fwrite(&entries[i], sizeof(archive_entry), 1, out) == 1;
+  }
+
+  for (const auto &in : inputs) {
+    ok = ok && std::fwrite(in.name.data(), 1, in.name.size(), out) == in.name.size();
+  }
+
+  ok = std::fclose(out) == 0 && ok;
+
+  if (!ok) {
+    log_error("Unable to write {}", pack_path);
+    std::remove(pack_path);
+    return false;
+  }
+
+  fmt::print("Packed {} files, {} bytes, into {} bytes of {}\n", inputs.size(), total_size,
+             position, pack_path);
+  return true;
+}
+
+static auto list_pack(const char *pack_path) -> bool {
+  const auto pack{files::archive::open(pack_path)};
+  if (!pack) {
+    return false;
+  }
+
+  fmt::print("{:>16} {:>12} {:>12} {:>6}  {}\n", "offset", "size", "stored", "method", "name");
+  for (const auto &e : pack->entries()) {
+    fmt::print("{:>16} {:>12} {:>12} {:>6}  {}\n", e.offset, e.size, e.stored_size,
+               compression_name(e.method), pack->name(e));
+  }
+
+  return true;
+}
+
+/*
+ * Compresses every input with each codec and reports the compression ratio and throughput, then
+ * decompresses the payloads through the same parallel path the engine uses. Throughputs are in
+ * decompressed MB/s, keeping the best of the runs.
+ */
+static auto bench_codecs(const pack_options &opts, usize repetitions,
+                         const vector<pack_input> &inputs) -> bool {
+  vector<files::file_data_t> contents{};
+  u64 total_size{0};
+
+  for (const auto &in : inputs) {
+    auto data{files::load_file(in.path.string().c_str(), false)};
+    if (!data) {
+      log_error("Unable to read {}", in.name);
+      return false;
+    }
+    total_size += data->size();
+    contents.push_back(std::move(*data));
+  }
+
+  if (total_size == 0) {
+    log_error("Nothing to benchmark");
+    return false;
+  }
+
+  fmt::print("{} files, {} bytes, chunks of {} bytes, best of {} runs on {} workers\n",
+             inputs.size(), total_size, opts.chunk_size, repetitions,
+             tasks::executor::get().num_workers());
+  fmt::print("{:<6} {:>8} {:>16} {:>16}\n", "codec", "ratio", "compress MB/s", "decompress MB/s");
+
+  const auto mb{static_cast<double>(total_size) / 1.0e6};
+
+  for (const auto method : {compression::lz4, compression::zstd}) {
+    vector<vector<std::byte>> payloads(contents.size());
+    u64 stored_size{0};
+
+    timers::generic_timer t{};
+    t.start();
+    for (usize i = 0; i < contents.size(); i++) {
+      auto payload{files::compress_payload(method, opts.chunk_size, contents[i])};
+      if (!payload) {
+        return false;
+      }
+      stored_size += payload->size();
+      payloads[i] = std::move(*payload);
+    }
+    const auto compress_s{t.stop()};
+
+    files::file_data_t out{};
+    double best_s{1.0e30};
+
+    for (usize r = 0; r < repetitions; r++) {
+      t.start();
+      for (usize i = 0; i < contents.size(); i++) {
+        out.resize(contents[i].size());
+        if (files::decompress_payload(method, opts.chunk_size, payloads[i], out)) {
+          log_error("Unable to decompress {}", inputs[i].name);
+          return false;
+        }
+      }
+      best_s = std::min(best_s, t.stop());
+    }
+
+    fmt::print("{:<6} {:>8.3f} {:>16.1f} {:>16.1f}\n", compression_name(method),
+               static_cast<double>(total_size) / static_cast<double>(stored_size), mb / compress_s,
+               mb / best_s);
+  }
+
+  return true;
+}
+
+static void print_usage() {
+  fmt::print("Usage:\n"
+             "  surge_pack create <pack file> [--align <bytes>] [--chunk <KiB>]\n"
+             "                    [--compress <none|lz4|zstd>] <files or directories>...\n"
+             "  surge_pack list <pack file>\n"
+             "  surge_pack bench <runs> [--chunk <KiB>] <files or directories>...\n"
+             "--compress applies to the files and directories that follow it, so each asset can\n"
+             "use its own codec. Files that do not get smaller are stored uncompressed.\n");
+}
+
+/*
+ * Parses the options and inputs from argv[first] on. Returns false on malformed arguments.
+ */
+static auto parse_inputs(int argc, char **argv, int first, pack_options &opts,
+                         vector<pack_input> &inputs) -> bool {
+  auto method{compression::none};
+
+  for (int i = first; i < argc; i++) {
+    const std::string_view arg{argv[i]};
+    const bool has_value{i + 1 < argc};
+
+    if (arg == "--align" && has_value) {
+      opts.alignment = static_cast<u32>(std::strtoul(argv[++i], nullptr, 10));
+      if (opts.alignment == 0 || (opts.alignment & (opts.alignment - 1)) != 0) {
+        log_error("The payload alignment must be a power of two");
+        return false;
+      }
+    } else if (arg == "--chunk" && has_value) {
+      const auto kib{std::strtoul(argv[++i], nullptr, 10)};
+      if (kib == 0 || kib > 64 * 1024) {
+        log_error("The chunk size must be between 1 and 65536 KiB");
+        return false;
+      }
+      opts.chunk_size = static_cast<u32>(kib * 1024);
+    } else if (arg == "--compress" && has_value) {
+      const auto m{parse_compression(argv[++i])};
+      if (!m) {
+        log_error("Unknown compression method {}", argv[i]);
+        return false;
+      }
+      method = *m;
+    } else if (arg.starts_with("--")) {
+      log_error("Unknown or incomplete option {}", arg);
+      return false;
+    } else if (!collect_input(inputs, argv[i], method)) {
+      return false;
+    }
+  }
+
+  if (inputs.empty()) {
+    print_usage();
+    return false;
+  }
+
+  return true;
+}
+
+auto main(int argc, char **argv) -> int {
+  allocators::mimalloc::init();
+
+  if (argc < 3) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const std::string_view command{argv[1]};
+
+  if (command == "list") {
+    return list_pack(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  pack_options opts{};
+  vector<pack_input> inputs{};
+
+  if (command == "bench") {
+    const auto repetitions{std::max(static_cast<usize>(std::strtoull(argv[2], nullptr, 10)),
+                                    usize{1})};
+    if (!parse_inputs(argc, argv, 3, opts, inputs)) {
+      return EXIT_FAILURE;
+    }
+    return bench_codecs(opts, repetitions, inputs) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  if (command != "create") {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  if (!parse_inputs(argc, argv, 3, opts, inputs)) {
+    return EXIT_FAILURE;
+  }
+
+  return create_pack(argv[2], opts, inputs) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
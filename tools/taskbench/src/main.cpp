@@ -0,0 +1,162 @@
+#include "sc_allocators.hpp"
+#include "sc_container_types.hpp"
+#include "sc_glm_includes.hpp"
+#include "sc_integer_types.hpp"
+#include "sc_tasks.hpp"
+#include "sc_timers.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <random>
+#include <string_view>
+
+using namespace surge;
+
+/*
+ * Compares the tasks::parallel_* helpers with plain serial loops over a range of sizes, including
+ * sizes small enough for the helpers to fall back to serial execution. Each workload is repeated
+ * and the best time is kept, and a checksum of the results is printed so the work cannot be
+ * optimized out.
+ */
+
+struct result {
+  double best_s{1.0e30};
+  double checksum{0};
+};
+
+template <typename F> static auto measure(usize repetitions, F &&f) -> result {
+  result r{};
+  for (usize i = 0; i < repetitions; i++) {
+    timers::generic_timer t{};
+    t.start();
+    r.checksum += f();
+    const auto elapsed{t.stop()};
+    if (elapsed < r.best_s) {
+      r.best_s = elapsed;
+    }
+  }
+  return r;
+}
+
+static void print_result(std::string_view workload, usize size, std::string_view variant,
+                         const result &r) {
+  fmt::print("{:<16} {:>9} {:<10} {:>10.3f} ms {:>8.2f} ns/item  (checksum {:.6g})\n", workload,
+             size, variant, r.best_s * 1.0e3, r.best_s * 1.0e9 / static_cast<double>(size),
+             r.checksum);
+}
+
+struct sprite_transform {
+  glm::vec3 position{0.0f};
+  glm::vec2 scale{1.0f};
+};
+
+static auto model(const sprite_transform &t) -> glm::mat4 {
+  return glm::scale(glm::translate(glm::mat4{1.0f}, t.position), glm::vec3{t.scale, 1.0f});
+}
+
+/*
+ * Model matrices: what sprite_database::add does for every sprite of a frame, writing into a
+ * preallocated output the way a sprite system fills its slots.
+ */
+static auto matrices_serial(const vector<sprite_transform> &in, vector<glm::mat4> &out) -> double {
+  for (usize i = 0; i < in.size(); i++) {
+    out[i] = model(in[i]);
+  }
+  return static_cast<double>(out.back()[3][0]);
+}
+
+static auto matrices_parallel(const vector<sprite_transform> &in, vector<glm::mat4> &out)
+    -> double {
+  tasks::parallel_for(0, in.size(), [&](usize i) { out[i] = model(in[i]); });
+  return static_cast<double>(out.back()[3][0]);
+}
+
+/*
+ * Visible area: sums the area of every sprite inside a viewport, a map and a reduction per item.
+ */
+static auto visible_area(const sprite_transform &t) -> double {
+  const bool inside{t.position.x >= 0.0f && t.position.x < 1920.0f && t.position.y >= 0.0f
+                    && t.position.y < 1080.0f};
+  return inside ? static_cast<double>(t.scale.x * t.scale.y) : 0.0;
+}
+
+static auto area_serial(const vector<sprite_transform> &in) -> double {
+  double sum{0.0};
+  for (const auto &t : in) {
+    sum += visible_area(t);
+  }
+  return sum;
+}
+
+static auto area_parallel(const vector<sprite_transform> &in) -> double {
+  return tasks::parallel_reduce(
+      0, in.size(), 0.0, [&](usize i) { return visible_area(in[i]); },
+      [](double a, double b) { return a + b; });
+}
+
+/*
+ * Depth sort: sorting 64 bit keys made of a depth and a texture index, as a renderer does before
+ * batching.
+ */
+static auto sort_serial(const vector<u64> &keys, vector<u64> &work) -> double {
+  std::copy(keys.begin(), keys.end(), work.begin());
+  std::sort(work.begin(), work.end());
+  return static_cast<double>(work[work.size() / 2] >> 32);
+}
+
+static auto sort_parallel(const vector<u64> &keys, vector<u64> &work) -> double {
+  std::copy(keys.begin(), keys.end(), work.begin());
+  tasks::parallel_sort(work.begin(), work.end());
+  return static_cast<double>(work[work.size() / 2] >> 32);
+}
+
+auto main(int argc, char **argv) -> int {
+  allocators::mimalloc::init();
+
+  const auto repetitions{argc > 1 ? static_cast<usize>(std::strtoull(argv[1], nullptr, 10)) : 10};
+
+  fmt::print("Best of {} runs on {} workers\n", repetitions,
+             tasks::executor::get().num_workers());
+
+  std::mt19937 rng{1234};
+  std::uniform_real_distribution<float> coord{-200.0f, 2200.0f};
+  std::uniform_real_distribution<float> size{8.0f, 128.0f};
+  std::uniform_int_distribution<u64> key{};
+
+  constexpr std::array<usize, 4> sizes{1 << 10, 1 << 14, 1 << 18, 1 << 20};
+
+  for (const auto n : sizes) {
+    vector<sprite_transform> transforms(n);
+    for (auto &t : transforms) {
+      t.position = glm::vec3{coord(rng), coord(rng), 0.1f};
+      t.scale = glm::vec2{size(rng), size(rng)};
+    }
+
+    vector<u64> keys(n);
+    for (auto &k : keys) {
+      k = key(rng);
+    }
+
+    vector<glm::mat4> matrices(n);
+    vector<u64> work(n);
+
+    print_result("model matrices", n, "serial",
+                 measure(repetitions, [&] { return matrices_serial(transforms, matrices); }));
+    print_result("model matrices", n, "parallel",
+                 measure(repetitions, [&] { return matrices_parallel(transforms, matrices); }));
+
+    print_result("visible area", n, "serial",
+                 measure(repetitions, [&] { return area_serial(transforms); }));
+    print_result("visible area", n, "parallel",
+                 measure(repetitions, [&] { return area_parallel(transforms); }));
+
+    print_result("depth sort", n, "serial",
+                 measure(repetitions, [&] { return sort_serial(keys, work); }));
+    print_result("depth sort", n, "parallel",
+                 measure(repetitions, [&] { return sort_parallel(keys, work); }));
+  }
+
+  return EXIT_SUCCESS;
+}
\ No newline at end of file